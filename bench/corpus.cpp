@@ -0,0 +1,303 @@
+#include "corpus.hpp"
+#include "nuo/mapped_file.hpp"
+#include <cstdint>
+#include <cstdio>
+
+namespace bench {
+
+namespace {
+
+// SplitMix64, so that the corpora do not depend on the standard library
+class Random {
+private:
+  uint64_t state;
+
+public:
+  Random(uint64_t seed) : state(seed) {}
+
+  uint64_t next() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  // A number in [0, bound)
+  uint64_t below(uint64_t bound) { return next() % bound; }
+
+  bool chance(unsigned percent) { return below(100) < percent; }
+
+  template <typename T, std::size_t N> const T &pick(const T (&items)[N]) {
+    return items[below(N)];
+  }
+};
+
+const char *const words[] = {
+    "json",   "parser", "stream", "token",  "value", "object", "list",
+    "string", "number", "fast",   "simple", "bench", "nuo",    "tree",
+    "key",    "index",  "memory", "cache",  "vector"};
+
+// Words that are not ASCII, written directly as UTF-8 or as escape sequences
+const char *const wideWords[] = {
+    "\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF",
+    "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E",
+    "caf\xC3\xA9",
+    "\\u30c4\\u30a4\\u30fc\\u30c8",
+    "\\ud83d\\ude00",
+    "line\\nbreak",
+    "\\\"quoted\\\"",
+    "tab\\tseparated"};
+
+const char *const languages[] = {"ja", "en", "es", "fr", "pt", "ko"};
+
+std::string number(uint64_t value) { return std::to_string(value); }
+
+std::string sentence(Random &random, std::size_t count) {
+  std::string result;
+  for (std::size_t i = 0; i < count; i++) {
+    if (i > 0) {
+      result += ' ';
+    }
+    result += random.chance(20) ? random.pick(wideWords) : random.pick(words);
+  }
+  return result;
+}
+
+std::string twitterUser(Random &random, uint64_t id) {
+  std::string name = random.pick(words);
+  name += number(random.below(10000));
+  return R"({"id":)" + number(id) + R"(,"id_str":")" + number(id) +
+         R"(","name":")" + sentence(random, 2) + R"(","screen_name":")" +
+         name + R"(","location":")" +
+         (random.chance(50) ? sentence(random, 1) : "") +
+         R"(","description":")" + sentence(random, 12) +
+         R"(","url":null,"entities":{"description":{"urls":[]}},)"
+         R"("protected":false,"followers_count":)" +
+         number(random.below(100000)) +
+         R"(,"friends_count":)" + number(random.below(5000)) +
+         R"(,"listed_count":)" + number(random.below(100)) +
+         R"(,"created_at":"Sun Aug 31 00:29:15 +0000 2014",)"
+         R"("favourites_count":)" +
+         number(random.below(10000)) + R"(,"utc_offset":)" +
+         (random.chance(50) ? "null" : number(random.below(36000))) +
+         R"(,"time_zone":null,"geo_enabled":)" +
+         (random.chance(30) ? "true" : "false") +
+         R"(,"verified":false,"statuses_count":)" +
+         number(random.below(200000)) + R"(,"lang":")" +
+         random.pick(languages) +
+         R"(","profile_background_color":"C0DEED",)"
+         R"("profile_image_url":"http:\/\/pbs.twimg.com\/profile_images\/)" +
+         number(id) +
+         R"(\/normal.jpeg","default_profile":true,"following":false})";
+}
+
+std::string twitterStatus(Random &random, uint64_t id) {
+  std::string mentions;
+  auto count = random.below(3);
+  for (uint64_t i = 0; i < count; i++) {
+    auto userId = random.below(3000000000ULL);
+    mentions += std::string(i > 0 ? "," : "") + R"({"screen_name":")" +
+                random.pick(words) + R"(","name":")" + sentence(random, 2) +
+                R"(","id":)" + number(userId) + R"(,"id_str":")" +
+                number(userId) + R"(","indices":[3,)" +
+                number(4 + random.below(20)) + "]}";
+  }
+  auto language = random.pick(languages);
+  return R"({"metadata":{"result_type":"recent","iso_language_code":")" +
+         std::string(language) +
+         R"("},"created_at":"Sun Aug 31 00:29:15 +0000 2014","id":)" +
+         number(id) + R"(,"id_str":")" + number(id) + R"(","text":")" +
+         sentence(random, 8 + random.below(20)) +
+         R"(","source":"<a href=\"http:\/\/twitter.com\" rel=\"nofollow\">Web<\/a>",)"
+         R"("truncated":false,"in_reply_to_status_id":null,"user":)" +
+         twitterUser(random, random.below(3000000000ULL)) +
+         R"(,"geo":null,"coordinates":null,"place":null,"retweet_count":)" +
+         number(random.below(1000)) + R"(,"favorite_count":)" +
+         number(random.below(1000)) +
+         R"(,"entities":{"hashtags":[],"symbols":[],"urls":[],"user_mentions":[)" +
+         mentions + R"(]},"favorited":false,"retweeted":false,"lang":")" +
+         language + R"("})";
+}
+
+std::string twitter(double scale) {
+  auto random = Random(1);
+  std::string result = R"({"statuses":[)";
+  auto count = (std::size_t)(400 * scale) + 1;
+  for (std::size_t i = 0; i < count; i++) {
+    if (i > 0) {
+      result += ",\n";
+    }
+    result += twitterStatus(random, 505874924095815681ULL + i);
+  }
+  result += R"(],"search_metadata":{"completed_in":0.087,"max_id":505874924095815681,)"
+            R"("query":"%E4%B8%80","refresh_url":"?since_id=505874924095815681",)"
+            R"("count":100,"since_id":0}})";
+  return result;
+}
+
+// A coordinate with as many digits as the GeoJSON exports have
+std::string coordinate(Random &random, int whole, int range) {
+  char buffer[40];
+  auto fraction = (double)random.below(1000000000000000ULL) / 1e15;
+  std::snprintf(buffer, sizeof(buffer), "%.15f",
+                whole + (int)random.below(range) + fraction);
+  return buffer;
+}
+
+std::string canada(double scale) {
+  auto random = Random(2);
+  std::string result =
+      R"({"type":"FeatureCollection","features":[{"type":"Feature",)"
+      R"("properties":{"name":"Canada"},"geometry":{"type":"Polygon",)"
+      R"("coordinates":[)";
+  auto rings = (std::size_t)(120 * scale) + 1;
+  for (std::size_t ring = 0; ring < rings; ring++) {
+    result += ring > 0 ? ",\n[" : "[";
+    auto points = 50 + random.below(200);
+    for (uint64_t i = 0; i < points; i++) {
+      if (i > 0) {
+        result += ',';
+      }
+      result += "[" + coordinate(random, -141, 88) + "," +
+                coordinate(random, 41, 42) + "]";
+    }
+    result += "]";
+  }
+  result += "]}}]}";
+  return result;
+}
+
+std::string citmNames(Random &random, uint64_t base, std::size_t count) {
+  std::string result = "{";
+  for (std::size_t i = 0; i < count; i++) {
+    result += std::string(i > 0 ? "," : "") + "\"" + number(base + i * 6) +
+              "\":\"" + sentence(random, 1 + random.below(4)) + "\"";
+  }
+  return result + "}";
+}
+
+std::string citmIds(Random &random, uint64_t base, std::size_t count) {
+  std::string result = "[";
+  for (std::size_t i = 0; i < count; i++) {
+    result += std::string(i > 0 ? "," : "") + number(base + random.below(100));
+  }
+  return result + "]";
+}
+
+std::string citm(double scale) {
+  auto random = Random(3);
+  auto events = (std::size_t)(180 * scale) + 1;
+  std::string result = R"({"areaNames":)" + citmNames(random, 205705993, 17) +
+                       R"(,"audienceSubCategoryNames":{"337100890":"Abonné"},)"
+                       R"("blockNames":{},"events":{)";
+  for (std::size_t i = 0; i < events; i++) {
+    auto id = number(138586341 + i * 4);
+    result += std::string(i > 0 ? ",\n" : "") + "\"" + id +
+              R"(":{"description":null,"id":)" + id +
+              R"(,"logo":)" +
+              (random.chance(40)
+                   ? R"("\/images\/UE0AAAAACEKo6QAAAAZDSVRN")"
+                   : "null") +
+              R"(,"name":")" + sentence(random, 3) +
+              R"(","subTopicIds":)" + citmIds(random, 337184269, 4) +
+              R"(,"subjectCode":null,"subtitle":null,"topicIds":)" +
+              citmIds(random, 107888604, 2) + "}";
+  }
+  result += R"(},"performances":[)";
+  for (std::size_t i = 0; i < events * 5; i++) {
+    std::string prices;
+    std::string categories;
+    auto count = 1 + random.below(4);
+    for (uint64_t k = 0; k < count; k++) {
+      auto category = number(338937295 + random.below(1000));
+      prices += std::string(k > 0 ? "," : "") + R"({"amount":)" +
+                number(random.below(200) * 250) +
+                R"(,"audienceSubCategoryId":337100890,"seatCategoryId":)" +
+                category + "}";
+      categories += std::string(k > 0 ? "," : "") + R"({"areas":[)";
+      auto areas = 1 + random.below(6);
+      for (uint64_t a = 0; a < areas; a++) {
+        categories += std::string(a > 0 ? "," : "") + R"({"areaId":)" +
+                      number(205705993 + random.below(17) * 6) +
+                      R"(,"blockIds":[]})";
+      }
+      categories += R"(],"seatCategoryId":)" + category + "}";
+    }
+    result += std::string(i > 0 ? ",\n" : "") + R"({"eventId":)" +
+              number(138586341 + random.below(events) * 4) + R"(,"id":)" +
+              number(339887544 + i) +
+              R"(,"logo":null,"name":null,"prices":[)" + prices +
+              R"(],"seatCategories":[)" + categories +
+              R"(],"seatMapImage":null,"start":)" +
+              number(1372701600000ULL + random.below(100000000) * 1000) +
+              R"(,"venueCode":"PLEYEL_PLEYEL"})";
+  }
+  result += R"(],"seatCategoryNames":)" + citmNames(random, 338937295, 40) +
+            R"(,"venueNames":{"PLEYEL_PLEYEL":"Salle Pleyel"}})";
+  return result;
+}
+
+std::string deep(double scale) {
+  auto random = Random(4);
+  std::string result = "{";
+  auto chains = (std::size_t)(40 * scale) + 1;
+  for (std::size_t chain = 0; chain < chains; chain++) {
+    result += std::string(chain > 0 ? "," : "") + "\"chain" +
+              number(chain) + "\":";
+    std::string closing;
+    for (std::size_t level = 0; level < 400; level++) {
+      if (random.chance(50)) {
+        result += R"({"level":)" + number(level) + R"(,"next":)";
+        closing += "}";
+      } else {
+        result += "[" + number(level) + ",";
+        closing += "]";
+      }
+    }
+    result += R"("bottom")";
+    result.append(closing.rbegin(), closing.rend());
+  }
+  return result + "}";
+}
+
+std::string wide(double scale) {
+  auto random = Random(5);
+  std::string result = "{";
+  auto count = (std::size_t)(10000 * scale) + 1;
+  for (std::size_t i = 0; i < count; i++) {
+    result += std::string(i > 0 ? ",\n" : "") + "\"" + random.pick(words) +
+              "_" + number(i) + "\":";
+    switch (random.below(4)) {
+    case 0:
+      result += number(random.below(1000000));
+      break;
+    case 1:
+      result += "\"" + sentence(random, 2) + "\"";
+      break;
+    case 2:
+      result += random.chance(50) ? "true" : "null";
+      break;
+    default:
+      result += "[" + number(random.below(100)) + "," +
+                number(random.below(100)) + "]";
+    }
+  }
+  return result + "}";
+}
+
+} // namespace
+
+std::vector<Corpus> builtinCorpora(double scale) {
+  return {Corpus{"twitter", twitter(scale)}, Corpus{"canada", canada(scale)},
+          Corpus{"citm", citm(scale)}, Corpus{"deep", deep(scale)},
+          Corpus{"wide", wide(scale)}};
+}
+
+Corpus corpusFromFile(const std::string &path) {
+  auto file = nuo::MappedFile(path);
+  auto name = path.substr(path.find_last_of("/\\") + 1);
+  name = name.substr(0, name.find('.'));
+  return Corpus{name, std::string(file.view())};
+}
+
+} // namespace bench
@@ -0,0 +1,35 @@
+#ifndef NUO_BENCH_CORPUS_HPP
+#define NUO_BENCH_CORPUS_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// A Json text that the benchmarks are run against
+class Corpus {
+public:
+  std::string name;
+  std::string text;
+};
+
+// The built in corpora. These are generated from a fixed seed, so the text
+// is byte for byte the same on every run and every platform. `scale`
+// multiplies the size of every corpus
+//
+// - twitter: Objects of a search API response with a lot of strings, non
+//   ASCII text, escape sequences, and nulls
+// - canada: GeoJSON polygons, almost entirely decimals in nested lists
+// - citm: Event catalog with wide objects keyed by numeric ids, and integers
+// - deep: Objects and lists nested hundreds of levels deep
+// - wide: One object with ten thousand keys
+std::vector<Corpus> builtinCorpora(double scale);
+
+// Read a corpus from a file, named after the file without its directory and
+// extension. Throws nuo::Exception if the file could not be read
+Corpus corpusFromFile(const std::string &path);
+
+} // namespace bench
+
+#endif
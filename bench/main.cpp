@@ -0,0 +1,401 @@
+#include "corpus.hpp"
+#include "nuo/exception.hpp"
+#include "nuo/json.hpp"
+#include "nuo/json_parser.hpp"
+#include "nuo/json_ref.hpp"
+#include "nuo/maybe.hpp"
+#include "nuo/vague.hpp"
+#include "nuo/vec.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef NUO_VERSION
+#define NUO_VERSION "unknown"
+#endif
+
+#ifndef NUO_BUILD_TYPE
+#define NUO_BUILD_TYPE "unknown"
+#endif
+
+namespace {
+
+// Results are added to this, so that the compiler cannot drop the work that is
+// measured
+volatile std::size_t sink = 0;
+
+void keep(std::size_t value) { sink = sink + value; }
+
+class Options {
+public:
+  std::string output = "nuobench.json";
+  std::string filter;
+  std::string baseline;
+  std::vector<std::string> corpora;
+  double scale = 1;
+  double threshold = 0;
+  unsigned samples = 7;
+  double sampleSeconds = 0.05;
+};
+
+class Result {
+public:
+  std::string name;
+
+  // Bytes of Json text and number of items handled in one iteration. These
+  // are zero if they do not apply to the benchmark
+  std::size_t bytes;
+  std::size_t items;
+
+  std::size_t iterations;
+
+  // Median time of one iteration over all samples
+  double nanoseconds;
+};
+
+// Runs `count` iterations of a benchmark and returns how long they took in
+// nanoseconds. Work that should not be measured, like creating the values
+// that a benchmark destroys, is done outside of the returned time
+using Batch = std::function<double(std::size_t count)>;
+
+using Clock = std::chrono::steady_clock;
+
+double since(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// A batch that measures every call of the function
+template <typename Fn> Batch loop(Fn fn) {
+  return [fn](std::size_t count) {
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < count; i++) {
+      fn();
+    }
+    return since(start);
+  };
+}
+
+class Runner {
+private:
+  const Options &options;
+
+public:
+  std::vector<Result> results;
+
+  Runner(const Options &options) : options(options) {}
+
+  void run(const std::string &name, std::size_t bytes, std::size_t items,
+           const Batch &batch) {
+    if (name.find(options.filter) == std::string::npos) {
+      return;
+    }
+    // Warm up, then find how many iterations fill one sample
+    std::size_t count = 1;
+    auto elapsed = batch(count);
+    while (elapsed < options.sampleSeconds * 1e9 && count < (1u << 30)) {
+      count = elapsed > 0 ? std::max<std::size_t>(
+                                count * 2, (std::size_t)(count * 1.2 *
+                                                         options.sampleSeconds *
+                                                         1e9 / elapsed))
+                          : count * 2;
+      elapsed = batch(count);
+    }
+    std::vector<double> times;
+    for (unsigned i = 0; i < options.samples; i++) {
+      times.push_back(batch(count) / count);
+    }
+    std::sort(times.begin(), times.end());
+    results.push_back(
+        Result{name, bytes, items, count, times[times.size() / 2]});
+    print(results.back());
+  }
+
+  static void print(const Result &result) {
+    std::printf("%-32s %14.1f ns", result.name.c_str(), result.nanoseconds);
+    if (result.bytes > 0) {
+      std::printf(" %10.1f MB/s",
+                  result.bytes * 1e3 / result.nanoseconds);
+    }
+    std::printf("\n");
+  }
+};
+
+// Keys at the top level of a corpus, which are looked up by the benchmarks
+class KeyCollector {
+public:
+  std::vector<std::string> keys;
+  std::size_t depth = 0;
+
+  void startObject() { depth++; }
+  void endObject() { depth--; }
+  void startList() { depth++; }
+  void endList() { depth--; }
+  void key(std::string_view key) {
+    if (depth == 1) {
+      keys.emplace_back(key);
+    }
+  }
+  void string(std::string_view val) {}
+  void integer(int64_t val) {}
+  void decimal(double val) {}
+  void boolean(bool val) {}
+  void null() {}
+};
+
+// Visit every value through borrowed views, as a read-only consumer would
+std::size_t walk(nuo::JsonRef ref) {
+  std::size_t total = 1;
+  if (ref.isString()) {
+    total += ref.asString().size();
+  } else if (ref.isList()) {
+    for (auto &elem : ref.asList()) {
+      total += walk(elem);
+    }
+  } else if (ref.isJson()) {
+    ref.forEachMember([&](std::string_view key, nuo::JsonRef member) {
+      total += key.size() + walk(member);
+    });
+  }
+  return total;
+}
+
+void jsonBenchmarks(Runner &runner, const bench::Corpus &corpus) {
+  auto &text = corpus.text;
+  auto json = nuo::Json(text);
+  auto keys = KeyCollector();
+  nuo::JsonParser::sax(text, keys);
+  auto value = nuo::JsonValue(json);
+  runner.run("json/parse/" + corpus.name, text.size(), 0, loop([&]() {
+               auto parsed = nuo::Json(text);
+               keep(parsed.size());
+             }));
+  runner.run("json/serialize/" + corpus.name, text.size(), 0, loop([&]() {
+               keep(json.toString().size());
+             }));
+  runner.run("json/lookup/" + corpus.name, 0, keys.keys.size(), loop([&]() {
+               for (auto &key : keys.keys) {
+                 keep((std::size_t)json[key].getType());
+               }
+             }));
+  runner.run("json/walk/" + corpus.name, text.size(), 0, loop([&]() {
+               keep(walk(json));
+             }));
+  runner.run("json/copy/" + corpus.name, text.size(), 0, loop([&]() {
+               auto copy = json;
+               keep(copy.size());
+             }));
+  runner.run("json/destroy/" + corpus.name, text.size(), 0,
+             [&](std::size_t count) {
+               std::vector<nuo::Json> copies(count, json);
+               auto start = Clock::now();
+               copies.clear();
+               return since(start);
+             });
+  runner.run("jsonvalue/copy/" + corpus.name, text.size(), 0, loop([&]() {
+               auto copy = value;
+               keep((std::size_t)copy.getType());
+             }));
+  runner.run("jsonvalue/destroy/" + corpus.name, text.size(), 0,
+             [&](std::size_t count) {
+               std::vector<nuo::JsonValue> copies(count, value);
+               auto start = Clock::now();
+               copies.clear();
+               return since(start);
+             });
+}
+
+void containerBenchmarks(Runner &runner) {
+  const unsigned count = 100000;
+  runner.run("vec/push/int", 0, count, loop([&]() {
+               nuo::Vec<int> vec;
+               for (unsigned i = 0; i < count; i++) {
+                 vec.push((int)i);
+               }
+               keep(vec.length());
+             }));
+  runner.run("vec/push/string", 0, count, loop([&]() {
+               nuo::Vec<std::string> vec;
+               for (unsigned i = 0; i < count; i++) {
+                 vec.push("a string longer than the small buffer");
+               }
+               keep(vec.length());
+             }));
+  nuo::Vec<int> ints;
+  for (unsigned i = 0; i < count; i++) {
+    ints.push((int)i);
+  }
+  runner.run("vec/iterate/int", 0, count, loop([&]() {
+               std::size_t total = 0;
+               for (auto value : ints) {
+                 total += value;
+               }
+               keep(total);
+             }));
+  runner.run("vec/copy/int", 0, count, loop([&]() {
+               auto copy = ints;
+               keep(copy.length());
+             }));
+  runner.run("maybe/construct/int", 0, 1, loop([&]() {
+               auto value = nuo::Maybe<int>(7);
+               keep(value.has());
+             }));
+  auto maybe = nuo::Maybe<std::string>(std::string("a string value"));
+  runner.run("maybe/copy/string", 0, 1, loop([&]() {
+               auto copy = maybe;
+               keep(copy.has());
+             }));
+  runner.run("vague/construct/int", 0, 1, loop([&]() {
+               auto value = nuo::Vague<int>(7);
+               keep(value.has());
+             }));
+  auto vague = nuo::Vague<std::string>(std::string("a string value"));
+  runner.run("vague/copy/string", 0, 1, loop([&]() {
+               auto copy = vague;
+               keep(copy.has());
+             }));
+}
+
+void writeResults(const Options &options, const std::vector<Result> &results) {
+  std::vector<nuo::JsonValue> list;
+  for (auto &result : results) {
+    auto entry = nuo::Json()
+                     ._("name", result.name)
+                     ._("bytes", (uint64_t)result.bytes)
+                     ._("items", (uint64_t)result.items)
+                     ._("iterations", (uint64_t)result.iterations)
+                     ._("nanoseconds", result.nanoseconds);
+    if (result.bytes > 0) {
+      entry._("megabytesPerSecond", result.bytes * 1e3 / result.nanoseconds);
+    }
+    list.push_back(entry);
+  }
+  auto report = nuo::Json()
+                    ._("library", "nuo")
+                    ._("version", NUO_VERSION)
+                    ._("buildType", NUO_BUILD_TYPE)
+                    ._("compiler", __VERSION__)
+                    ._("scale", options.scale)
+                    ._("samples", (uint64_t)options.samples)
+                    ._("results", list);
+  auto file = std::ofstream(options.output);
+  if (!file) {
+    throw nuo::Exception("Could not write the results to " + options.output);
+  }
+  file << report.toString() << "\n";
+}
+
+// Compares the results with an earlier run. Returns false if any benchmark is
+// slower than the threshold allows
+bool compare(const Options &options, const std::vector<Result> &results) {
+  auto baseline = nuo::Json::fromFile(options.baseline);
+  std::map<std::string, double> before;
+  for (auto &entry : baseline["results"].asList()) {
+    auto json = entry.asJson();
+    before[json["name"].asString()] = json["nanoseconds"].isInt()
+                                          ? json["nanoseconds"].asInt()
+                                          : json["nanoseconds"].asDouble();
+  }
+  if (!baseline["scale"].isNone() &&
+      (baseline["scale"].isInt() ? (double)baseline["scale"].asInt()
+                                 : baseline["scale"].asDouble()) !=
+          options.scale) {
+    std::printf("\nThe baseline was run at a different scale, so the Json "
+                "benchmarks are not comparable\n");
+  }
+  bool passed = true;
+  std::printf("\nCompared with %s\n", options.baseline.c_str());
+  for (auto &result : results) {
+    auto found = before.find(result.name);
+    if (found == before.end() || found->second <= 0) {
+      continue;
+    }
+    auto change = (result.nanoseconds / found->second - 1) * 100;
+    bool regressed = options.threshold > 0 && change > options.threshold;
+    passed = passed && !regressed;
+    std::printf("%-32s %+8.1f%%%s\n", result.name.c_str(), change,
+                regressed ? "  regression" : "");
+  }
+  return passed;
+}
+
+void usage() {
+  std::printf(
+      "Usage: nuobench [options]\n"
+      "  --output <path>      Where to write the results (nuobench.json)\n"
+      "  --filter <text>      Only run benchmarks with this in their name\n"
+      "  --corpus <path>      Also benchmark this Json file, like the real\n"
+      "                       twitter.json, canada.json or citm_catalog.json\n"
+      "  --scale <factor>     Size of the built in corpora (1)\n"
+      "  --samples <count>    Samples for each benchmark (7)\n"
+      "  --baseline <path>    Compare with the results of an earlier run\n"
+      "  --threshold <pct>    Fail if a benchmark is this much slower than\n"
+      "                       the baseline\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--help") {
+      usage();
+      return 0;
+    }
+    if (i + 1 >= argc) {
+      usage();
+      return 2;
+    }
+    std::string val = argv[++i];
+    if (arg == "--output") {
+      options.output = val;
+    } else if (arg == "--filter") {
+      options.filter = val;
+    } else if (arg == "--corpus") {
+      options.corpora.push_back(val);
+    } else if (arg == "--scale") {
+      options.scale = std::stod(val);
+    } else if (arg == "--samples") {
+      options.samples = std::max(1, std::stoi(val));
+    } else if (arg == "--baseline") {
+      options.baseline = val;
+    } else if (arg == "--threshold") {
+      options.threshold = std::stod(val);
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (std::strcmp(NUO_BUILD_TYPE, "Release") != 0) {
+    std::printf("This is not a Release build, so the results do not reflect "
+                "the performance of the library\n\n");
+  }
+  try {
+    auto corpora = bench::builtinCorpora(options.scale);
+    for (auto &path : options.corpora) {
+      corpora.push_back(bench::corpusFromFile(path));
+    }
+    auto runner = Runner(options);
+    for (auto &corpus : corpora) {
+      jsonBenchmarks(runner, corpus);
+    }
+    containerBenchmarks(runner);
+    writeResults(options, runner.results);
+    std::printf("\nResults written to %s\n", options.output.c_str());
+    if (!options.baseline.empty() && !compare(options, runner.results)) {
+      return 1;
+    }
+  } catch (nuo::Exception &err) {
+    std::cerr << err.what() << "\n";
+    return 2;
+  }
+  return 0;
+}
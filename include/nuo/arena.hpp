@@ -0,0 +1,101 @@
+#ifndef NUO_ARENA_HPP
+#define NUO_ARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace nuo {
+
+/**
+ * @brief A monotonic allocator. Memory is handed out from large blocks by
+ * moving a cursor forward, and is never freed individually. All blocks are
+ * released together when the arena is cleared or destroyed, so only values
+ * that do not need their destructors to run can be placed in it
+ *
+ */
+class Arena {
+private:
+  // Header at the start of every block. The usable memory follows it
+  class Block {
+  public:
+    Block *previous;
+    std::size_t size;
+  };
+
+  // The block that allocations are currently made from
+  Block *head;
+
+  char *cursor;
+
+  char *limit;
+
+  // Size of the next block. This grows so that large documents need only a
+  // few blocks
+  std::size_t blockSize;
+
+  std::size_t used;
+
+  // Add a block with room for at least `size` bytes
+  void grow(std::size_t size);
+
+public:
+  /**
+   * @brief Create an empty arena. No memory is allocated until it is needed
+   *
+   * @param initialBlockSize Size of the first block in bytes
+   */
+  Arena(std::size_t initialBlockSize = 4096);
+
+  Arena(Arena const &other) = delete;
+
+  Arena &operator=(Arena const &other) = delete;
+
+  Arena(Arena &&other) noexcept;
+
+  Arena &operator=(Arena &&other) noexcept;
+
+  /**
+   * @brief Allocate memory that is valid until the arena is cleared
+   *
+   * @param size Number of bytes
+   * @param align Alignment of the memory, which should be a power of two
+   * @return void*
+   */
+  void *allocate(std::size_t size,
+                 std::size_t align = alignof(std::max_align_t));
+
+  /**
+   * @brief Construct a value in the arena
+   *
+   * @return T*
+   */
+  template <typename T, typename... Args> T *make(Args &&...args) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "Values in an arena are never destroyed");
+    return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Copy the characters into the arena
+   *
+   * @param val Characters to copy
+   * @return std::string_view View of the copy
+   */
+  std::string_view copy(std::string_view val);
+
+  // Number of bytes handed out since the arena was created or cleared
+  std::size_t size() const noexcept;
+
+  // Release all memory at once. Everything allocated before is invalid
+  void clear() noexcept;
+
+  ~Arena() noexcept;
+};
+
+} // namespace nuo
+
+#endif
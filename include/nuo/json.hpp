@@ -1,14 +1,21 @@
 #ifndef NUO_JSON_HPP
 #define NUO_JSON_HPP
 
+#include "nuo/json_key.hpp"
+#include "nuo/vague.hpp"
+#include <atomic>
 #include <cstdint>
+#include <cstring>
 #include <initializer_list>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace nuo {
 
-enum class JsonValueType {
+enum class JsonValueType : uint8_t {
   integer,
   decimal,
   string,
@@ -20,20 +27,98 @@ enum class JsonValueType {
 };
 
 class Json;
+class JsonError;
+class JsonLimits;
 
 class JsonValue {
 private:
-  // The heap allocated data of this JsonValue
-  void *data;
-
-  // Type of the value, used to allocate and deallocate, and also to identify
-  // data type
+  // Integers, decimals, booleans and strings of up to `maxInline` bytes are
+  // kept in the storage itself. Objects, lists and longer strings are
+  // allocated on the heap, and the storage has the pointer to them. The last
+  // byte of the storage is the length of an inline string, or `heapString`
+  // if the string is on the heap
+  alignas(8) unsigned char storage[15];
+
+  // Type of the value, used to identify what is in the storage
   JsonValueType type;
 
-  // Private constructor to manually assign type and data. This is used only for
-  JsonValue(JsonValueType type, void *data);
+  static constexpr std::size_t maxInline = 14;
+  static constexpr unsigned char heapString = 0xFF;
+
+  // The count of the values that share a heap allocation
+  class Counted {
+  public:
+    Counted() : references(1) {}
+
+    std::atomic<std::size_t> references;
+  };
+
+  // A heap allocation, which is shared by copies of the value. It is copied
+  // before it is changed if it is shared, so copying a value never copies
+  // the objects, lists or strings in it
+  template <typename T> class Shared : public Counted {
+  public:
+    template <typename... Args>
+    Shared(Args &&...args) : Counted(), value(std::forward<Args>(args)...) {}
+
+    T value;
+  };
+
+  // A value of the type with nothing in the storage, such as none
+  explicit JsonValue(JsonValueType type);
+
+  template <typename T> T load() const {
+    T result;
+    std::memcpy(&result, storage, sizeof(T));
+    return result;
+  }
+
+  template <typename T> void store(T val) {
+    std::memcpy(storage, &val, sizeof(T));
+  }
+
+  // Allocate the heap value of an object, a list or a long string
+  template <typename T, typename... Args> void allocate(Args &&...args) {
+    store<Counted *>(new Shared<T>(std::forward<Args>(args)...));
+  }
+
+  template <typename T> Shared<T> *shared() const {
+    return static_cast<Shared<T> *>(load<Counted *>());
+  }
+
+  // The heap value of an object, a list or a long string, to be read
+  template <typename T> const T *heap() const { return &shared<T>()->value; }
+
+  // The heap value of an object, a list or a long string, to be changed. It
+  // is copied first if it is shared
+  template <typename T> T *unique() {
+    if (load<Counted *>()->references.load(std::memory_order_acquire) != 1) {
+      auto copy = new Shared<T>(shared<T>()->value);
+      release<T>();
+      store<Counted *>(copy);
+    }
+    return &shared<T>()->value;
+  }
+
+  // Drop the reference to the heap value, and free it if it was the last
+  template <typename T> void release() {
+    auto counted = load<Counted *>();
+    if (counted->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete static_cast<Shared<T> *>(counted);
+    }
+  }
+
+  // Set the storage to the string, which should not be in it already
+  void storeString(std::string_view val);
+
+  // The text of a string value, which is valid until the value changes
+  std::string_view view() const;
 
   friend class Json;
+  friend class JsonDiff;
+  friend class JsonParser;
+  friend class JsonPatch;
+  friend class JsonWriter;
 
 public:
   JsonValue();
@@ -68,6 +153,9 @@ public:
   JsonValue(std::string val);
   void operator=(const std::string val);
 
+  // std::string_view
+  JsonValue(std::string_view val);
+
   // C string
   JsonValue(const char *val);
   void operator=(const char *val);
@@ -166,6 +254,10 @@ public:
 
   std::string asString() const;
 
+  // The string without copying it. The view is valid until the value is
+  // changed or destroyed
+  std::string_view viewString() const;
+
   bool isBool() const;
 
   bool asBool() const;
@@ -174,12 +266,20 @@ public:
 
   Json asJson() const;
 
+  // The object without copying it. The reference is valid until the value is
+  // changed or destroyed
+  const Json &viewJson() const;
+
   bool isNone() const;
 
   bool isList() const;
 
   std::vector<JsonValue> asList() const;
 
+  // The values in the list without copying them. The span is valid until the
+  // value is changed or destroyed
+  std::span<const JsonValue> viewList() const;
+
   friend std::ostream &operator<<(std::ostream &os, const JsonValue &val);
 
   void clear();
@@ -189,21 +289,112 @@ public:
 
 class Json {
 private:
-  std::vector<std::string> keys;
+  // Keys are interned, so comparing two of them is comparing two pointers
+  std::vector<JsonKey> keys;
   std::vector<JsonValue> values;
 
   mutable unsigned level = 0;
   mutable unsigned spaces = 2;
 
+  // Members that are objects are indented by the spaces of the object they
+  // are in, unless their own spaces were set
+  mutable bool spacesSet = false;
+
   void setLevel(unsigned lev) const;
 
+  // The text of the object when it is at the level and indented by the
+  // number of spaces
+  std::string toString(unsigned lev, unsigned spc) const;
+
+  // Objects with more keys than this have an index. Comparing a few keys is
+  // cheaper than hashing one
+  static constexpr std::size_t smallObject = 16;
+
+  // Open addressing table of the positions of the keys, plus one so that
+  // zero is an empty slot. It is empty for small objects, and otherwise has
+  // a power of two slots, which is at least twice the number of keys. It is
+  // only changed along with the keys, so reading it from many threads is safe
+  std::vector<uint32_t> index;
+
+  // Number of slots in the index of an object with the number of keys, when
+  // the index is rebuilt. This is 0 for small objects
+  static std::size_t indexSlots(std::size_t keys);
+
+  // Rebuild the index after keys are moved, removed or inserted in the middle
+  void reindex();
+
+  // Find the position of a key with the hash in the index, using `equal` to
+  // compare the key at a position. Returns the number of keys if not found
+  template <typename Equal>
+  std::size_t probe(std::size_t hash, Equal equal) const;
+
+  // Position of the key, which is the number of keys if it is not there
+  std::size_t position(std::string_view key) const;
+
+  std::size_t position(const JsonKey &key) const;
+
+  // Add the key, which should not be in the object, and its value at the end
+  JsonValue &append(JsonKey key, JsonValue value);
+
+  // Put the key, which should not be in the object, and its value at the
+  // position
+  void insert(std::size_t pos, JsonKey key, JsonValue value);
+
+  // Remove the key and the value at the position
+  void remove(std::size_t pos);
+
+  // The value of the key, which is added with a none value if it is not there
+  JsonValue &slot(const JsonKey &key);
+
   friend class JsonValue;
+  friend class JsonDiff;
+  friend class JsonParser;
+  friend class JsonPatch;
+  friend class JsonRef;
+  friend class JsonWriter;
 
 public:
   Json();
 
   Json(std::string val);
 
+  // Parse the file at the provided path. The file is mapped into memory
+  // while parsing instead of being read into a string
+  static Json fromFile(const std::string &path);
+
+  /**
+   * @brief Parse Json text without throwing. Invalid text is reported as a
+   * problem that has the message, line and column of the first error found.
+   * Nothing is thrown while parsing, so this is cheap for invalid input
+   *
+   * @param text Json text
+   * @return Vague<Json>
+   */
+  static Vague<Json> tryParse(std::string_view text);
+
+  /**
+   * @brief Parse Json text without throwing, and get the details of the
+   * problem if the text is not valid
+   *
+   * @param text Json text
+   * @param error Set to the kind, byte offset, line and column of the problem
+   * @return Vague<Json>
+   */
+  static Vague<Json> tryParse(std::string_view text, JsonError &error);
+
+  /**
+   * @brief Parse Json text from a source that is not trusted without
+   * throwing. Text that is over any of the limits is a problem, and parsing
+   * stops as soon as a limit is crossed
+   *
+   * @param text Json text
+   * @param limits Limits of depth, size, string length and memory
+   * @param error Set to the kind, byte offset, line and column of the problem
+   * @return Vague<Json>
+   */
+  static Vague<Json> tryParse(std::string_view text, const JsonLimits &limits,
+                              JsonError &error);
+
   Json(Json const &other);
 
   Json(Json &&other) noexcept;
@@ -220,6 +411,9 @@ public:
 
   bool has(const std::string key) const;
 
+  // Remove the key and its value. Returns false if there is no such key
+  bool erase(const std::string &key);
+
   JsonValue &operator[](const std::string key);
 
   bool operator==(const Json &other) const;
@@ -0,0 +1,438 @@
+#ifndef NUO_JSON_BINDING_HPP
+#define NUO_JSON_BINDING_HPP
+
+#include "nuo/exception.hpp"
+#include "nuo/json.hpp"
+#include "nuo/json_parser.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace nuo {
+
+// Reads the values of Json text one at a time, in the order they appear. This
+// is used to parse Json directly into other types, without building a tree.
+// Every read function throws nuo::Exception if the next value is not of the
+// requested kind
+class JsonCursor {
+private:
+  std::string_view text;
+
+  JsonParser::Index index;
+
+  JsonParser::Token tok;
+
+  // The key being read, which stays valid until the next key
+  JsonParser::Token keyTok;
+
+  // Whether `tok` has been lexed but not consumed yet
+  bool peeked;
+
+  // Whether nothing has been read yet from each open object and list
+  std::vector<bool> first;
+
+  // Position after the last consumed token
+  std::size_t consumed;
+
+  // Consume the next token
+  JsonParser::Token &take();
+
+  // Throw an exception for the token that was found instead of `expected`
+  [[noreturn]] void fail(const char *expected) const;
+
+public:
+  JsonCursor(std::string_view text);
+
+  // Type of the next token, without consuming it. The type is null at the end
+  // of the text, which can be checked with `atEnd`
+  JsonParser::TokenType peek();
+
+  // Whether all tokens have been consumed
+  bool atEnd();
+
+  bool readBool();
+
+  int64_t readInt();
+
+  // Integers are also accepted
+  double readDouble();
+
+  void readString(std::string &result);
+
+  // Consume a null if it is the next value
+  bool readNull();
+
+  void beginObject();
+
+  /**
+   * @brief Move to the next member of the object that is being read. The
+   * value of the member is the next value to be read
+   *
+   * @param key Set to the key of the member. This is valid until the next call
+   * @return bool false if the end of the object was reached
+   */
+  bool nextKey(std::string_view &key);
+
+  void beginList();
+
+  // Move to the next element of the list that is being read. Returns false if
+  // the end of the list was reached
+  bool nextElement();
+
+  // Skip the next value, including everything inside it
+  void skip();
+
+  // Parse the next value into a JsonValue
+  JsonValue readValue();
+};
+
+// Writes compact Json text. It receives values the same way as the handlers
+// of JsonParser::sax, so it can also be used to minify text, and it inserts
+// the commas between values
+class JsonWriter {
+private:
+  // Whether anything has been written in each open object and list
+  std::vector<bool> first;
+
+  // Whether a key was just written, so that no comma is needed
+  bool afterKey;
+
+  void separate();
+
+public:
+  JsonWriter();
+
+  std::string result;
+
+  void startObject();
+  void endObject();
+  void startList();
+  void endList();
+  void key(std::string_view key);
+  void string(std::string_view val);
+  void integer(int64_t val);
+  void decimal(double val);
+  void boolean(bool val);
+  void null();
+
+  // Write a value that is in a JsonValue
+  void value(const JsonValue &val);
+
+  // Append the string to `result` in quotes. Quotes, backslashes and all
+  // control characters are escaped, so that the text is valid Json
+  static void escape(std::string &result, std::string_view val);
+};
+
+/**
+ * @brief Describes one field of a struct that is read from and written to
+ * Json. Structs declare their fields once, in a static function named
+ * `jsonFields` that returns a tuple of these:
+ *
+ *     class User {
+ *     public:
+ *       int64_t id;
+ *       std::string name;
+ *
+ *       static constexpr auto jsonFields() {
+ *         return std::make_tuple(nuo::JsonField("id", &User::id),
+ *                                nuo::JsonField("name", &User::name));
+ *       }
+ *     };
+ *
+ */
+template <typename Class, typename Member> class JsonField {
+public:
+  using MemberType = Member;
+
+  constexpr JsonField(std::string_view _name, Member Class::*_member)
+      : name(_name), member(_member) {}
+
+  std::string_view name;
+
+  Member Class::*member;
+};
+
+// Types that declare their fields for Json
+template <typename T>
+concept JsonBound = requires { T::jsonFields(); };
+
+template <typename T> class JsonBinding;
+
+// Reads and writes values of a type in Json. This supports booleans, numbers,
+// strings, JsonValue, std::vector and std::optional of supported types, and
+// types that declare their fields. It can be specialized for other types
+template <typename V> class JsonCodec {
+public:
+  static void read(JsonCursor &cursor, V &val) {
+    if constexpr (JsonBound<V>) {
+      JsonBinding<V>::read(cursor, val);
+    } else if constexpr (std::is_same_v<V, bool>) {
+      val = cursor.readBool();
+    } else if constexpr (std::is_integral_v<V>) {
+      auto num = cursor.readInt();
+      if constexpr (std::is_unsigned_v<V>) {
+        if ((num < 0) || ((uint64_t)num > std::numeric_limits<V>::max())) {
+          throw Exception("Integer " + std::to_string(num) +
+                          " is out of range for the field");
+        }
+      } else if ((num < std::numeric_limits<V>::min()) ||
+                 (num > std::numeric_limits<V>::max())) {
+        throw Exception("Integer " + std::to_string(num) +
+                        " is out of range for the field");
+      }
+      val = (V)num;
+    } else if constexpr (std::is_floating_point_v<V>) {
+      val = (V)cursor.readDouble();
+    } else if constexpr (std::is_same_v<V, std::string>) {
+      cursor.readString(val);
+    } else if constexpr (std::is_same_v<V, JsonValue>) {
+      val = cursor.readValue();
+    } else {
+      static_assert(JsonBound<V>, "This type cannot be read from Json");
+    }
+  }
+
+  static void write(JsonWriter &writer, const V &val) {
+    if constexpr (JsonBound<V>) {
+      JsonBinding<V>::write(writer, val);
+    } else if constexpr (std::is_same_v<V, bool>) {
+      writer.boolean(val);
+    } else if constexpr (std::is_integral_v<V>) {
+      writer.integer((int64_t)val);
+    } else if constexpr (std::is_floating_point_v<V>) {
+      writer.decimal((double)val);
+    } else if constexpr (std::is_same_v<V, std::string>) {
+      writer.string(val);
+    } else if constexpr (std::is_same_v<V, JsonValue>) {
+      writer.value(val);
+    } else {
+      static_assert(JsonBound<V>, "This type cannot be written as Json");
+    }
+  }
+};
+
+template <typename E> class JsonCodec<std::vector<E>> {
+public:
+  static void read(JsonCursor &cursor, std::vector<E> &val) {
+    val.clear();
+    cursor.beginList();
+    while (cursor.nextElement()) {
+      val.emplace_back();
+      JsonCodec<E>::read(cursor, val.back());
+    }
+  }
+
+  static void write(JsonWriter &writer, const std::vector<E> &val) {
+    writer.startList();
+    for (auto &elem : val) {
+      JsonCodec<E>::write(writer, elem);
+    }
+    writer.endList();
+  }
+};
+
+template <typename E> class JsonCodec<std::optional<E>> {
+public:
+  static void read(JsonCursor &cursor, std::optional<E> &val) {
+    if (cursor.readNull()) {
+      val.reset();
+    } else {
+      val.emplace();
+      JsonCodec<E>::read(cursor, *val);
+    }
+  }
+
+  static void write(JsonWriter &writer, const std::optional<E> &val) {
+    if (val.has_value()) {
+      JsonCodec<E>::write(writer, *val);
+    } else {
+      writer.null();
+    }
+  }
+};
+
+/**
+ * @brief Reads and writes a type that declares its fields, as a Json object.
+ * Keys are matched to fields with a perfect hash that is found at compile
+ * time, so each key costs one hash and one comparison. Keys without a field
+ * are skipped, and fields without a key keep their value
+ *
+ */
+template <typename T> class JsonBinding {
+private:
+  static constexpr auto fields = T::jsonFields();
+
+  static constexpr std::size_t count =
+      std::tuple_size_v<std::remove_cvref_t<decltype(fields)>>;
+
+  template <std::size_t... I>
+  static constexpr std::array<std::string_view, count>
+  makeNames(std::index_sequence<I...>) {
+    return {std::get<I>(fields).name...};
+  }
+
+  static constexpr auto names = makeNames(std::make_index_sequence<count>());
+
+  // Twice the number of fields, so that a seed is found quickly
+  static constexpr std::size_t tableSize = []() {
+    std::size_t size = 1;
+    while (size < 2 * count) {
+      size *= 2;
+    }
+    return size;
+  }();
+
+  // FNV-1a, with the seed mixed into the initial value
+  static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+    uint32_t result = 2166136261u ^ (seed * 2654435761u);
+    for (auto chr : key) {
+      result ^= (uint8_t)chr;
+      result *= 16777619u;
+    }
+    return result;
+  }
+
+  static constexpr bool hasDuplicateNames() {
+    for (std::size_t i = 0; i < count; i++) {
+      for (std::size_t j = i + 1; j < count; j++) {
+        if (names[i] == names[j]) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  static_assert(!hasDuplicateNames(), "Two fields have the same Json key");
+
+  // The first seed for which every field has its own slot in the table
+  static constexpr uint32_t seed = []() {
+    for (uint32_t candidate = 0; candidate < (1u << 16); candidate++) {
+      std::array<bool, tableSize> used{};
+      bool distinct = true;
+      for (auto &name : names) {
+        auto slot = hash(name, candidate) & (tableSize - 1);
+        if (used[slot]) {
+          distinct = false;
+          break;
+        }
+        used[slot] = true;
+      }
+      if (distinct) {
+        return candidate;
+      }
+    }
+    return UINT32_MAX;
+  }();
+
+  static_assert(seed != UINT32_MAX, "No perfect hash found for the keys");
+
+  // Index of the field in each slot, or -1 for an empty slot
+  static constexpr std::array<int32_t, tableSize> table = []() {
+    std::array<int32_t, tableSize> result{};
+    for (auto &slot : result) {
+      slot = -1;
+    }
+    for (std::size_t i = 0; i < count; i++) {
+      result[hash(names[i], seed) & (tableSize - 1)] = (int32_t)i;
+    }
+    return result;
+  }();
+
+  template <std::size_t I> static void readField(JsonCursor &cursor, T &val) {
+    constexpr auto field = std::get<I>(fields);
+    using Member = typename std::remove_cvref_t<decltype(field)>::MemberType;
+    JsonCodec<Member>::read(cursor, val.*(field.member));
+  }
+
+  template <std::size_t... I>
+  static constexpr auto makeReaders(std::index_sequence<I...>) {
+    return std::array<void (*)(JsonCursor &, T &), count>{&readField<I>...};
+  }
+
+  static constexpr auto readers = makeReaders(std::make_index_sequence<count>());
+
+  template <std::size_t... I>
+  static void writeFields(JsonWriter &writer, const T &val,
+                          std::index_sequence<I...>) {
+    ((writer.key(std::get<I>(fields).name),
+      JsonCodec<typename std::remove_cvref_t<decltype(std::get<I>(
+          fields))>::MemberType>::write(writer,
+                                        val.*(std::get<I>(fields).member))),
+     ...);
+  }
+
+public:
+  // Index of the field for the key, or -1 if there is no such field
+  static constexpr int32_t find(std::string_view key) {
+    if constexpr (count == 0) {
+      return -1;
+    } else {
+      auto index = table[hash(key, seed) & (tableSize - 1)];
+      return ((index >= 0) && (names[index] == key)) ? index : -1;
+    }
+  }
+
+  // Read an object from the cursor into the fields of `val`
+  static void read(JsonCursor &cursor, T &val) {
+    cursor.beginObject();
+    std::string_view key;
+    while (cursor.nextKey(key)) {
+      auto index = find(key);
+      if (index < 0) {
+        cursor.skip();
+      } else {
+        readers[index](cursor, val);
+      }
+    }
+  }
+
+  // Write the fields of `val` as an object
+  static void write(JsonWriter &writer, const T &val) {
+    writer.startObject();
+    writeFields(writer, val, std::make_index_sequence<count>());
+    writer.endObject();
+  }
+
+  /**
+   * @brief Parse Json text with an object at the top level into a value.
+   * Throws nuo::Exception if the text is not valid, or if a value does not
+   * match the type of its field
+   *
+   * @param text Json text
+   * @return T
+   */
+  static T parse(std::string_view text) {
+    T result{};
+    parse(text, result);
+    return result;
+  }
+
+  // Parse Json text into the fields of an existing value
+  static void parse(std::string_view text, T &val) {
+    auto cursor = JsonCursor(text);
+    read(cursor, val);
+    if (!cursor.atEnd()) {
+      throw Exception("Only one value is allowed at the top level");
+    }
+  }
+
+  // Write a value as compact Json text
+  static std::string serialize(const T &val) {
+    auto writer = JsonWriter();
+    write(writer, val);
+    return std::move(writer.result);
+  }
+};
+
+} // namespace nuo
+
+#endif
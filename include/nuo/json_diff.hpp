@@ -0,0 +1,57 @@
+#ifndef NUO_JSON_DIFF_HPP
+#define NUO_JSON_DIFF_HPP
+
+#include "nuo/json.hpp"
+#include "nuo/json_patch.hpp"
+
+namespace nuo {
+
+// Finds the differences between two Json documents, as a JSON Patch (RFC
+// 6902) or a JSON Merge Patch (RFC 7396). Subtrees that are the same value in
+// memory are skipped without being visited. Other subtrees are hashed once,
+// and the hashes are compared before any values, so the cost of a diff is
+// linear in the size of the documents. Numbers are compared by value and the
+// members of objects can be in any order, as in JSON Patch
+class JsonDiff {
+public:
+  /**
+   * @brief Find the JSON Patch that changes `source` into `target`. Changed
+   * objects are patched member by member, and changed lists are patched with
+   * the fewest insertions and removals around their longest common
+   * subsequence. Lists that are too long for that are patched element by
+   * element instead
+   *
+   * @param source The document before the change
+   * @param target The document after the change
+   * @return JsonPatch Empty if the documents are equal
+   */
+  static JsonPatch patch(const Json &source, const Json &target);
+
+  /**
+   * @brief Find the JSON Merge Patch that changes `source` into `target`.
+   * Lists are always replaced as a whole. Merge patches cannot set a member
+   * to null, so members that are null in `target` are removed instead
+   *
+   * @param source The document before the change
+   * @param target The document after the change
+   * @return Json Empty if the documents are equal
+   */
+  static Json mergePatch(const Json &source, const Json &target);
+
+  /**
+   * @brief Apply a JSON Merge Patch to the document. Members that are null in
+   * the patch are removed, objects are merged, and all other values replace
+   * the values in the document
+   *
+   * @param document The document to change
+   * @param patch The merge patch
+   */
+  static void applyMergePatch(Json &document, const Json &patch);
+
+private:
+  class Walker;
+};
+
+} // namespace nuo
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef NUO_JSON_DOCUMENT_HPP
+#define NUO_JSON_DOCUMENT_HPP
+
+#include "nuo/arena.hpp"
+#include "nuo/json.hpp"
+#include "nuo/mapped_file.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nuo {
+
+// A read-only Json document that does not copy its text. Keys and strings
+// without escape sequences are views into the text, which can be a memory
+// mapped file, and only strings with escape sequences are decoded into the
+// document. Any value can be at the top level. All values are in a single
+// array and decoded strings are in an arena, so a document of any size is
+// released with a few deallocations
+class JsonDocument {
+private:
+  // A value in the document. The values are stored in document order, and
+  // the values inside an object or list directly follow it
+  class Node {
+  public:
+    Node() : type(JsonValueType::null), end(0), key(), integer(0) {}
+
+    JsonValueType type;
+
+    // Index of the node after this value and all values inside it
+    uint32_t end;
+
+    // Key of the value, if it is inside an object
+    std::string_view key;
+
+    union {
+      int64_t integer;
+      double decimal;
+      bool boolean;
+      std::string_view string;
+    };
+  };
+
+  class Builder;
+
+  // Owned text, if the document is not created from a file. This is kept on
+  // the heap so that moving the document does not move the text
+  std::unique_ptr<const std::string> text;
+
+  MappedFile file;
+
+  std::vector<Node> nodes;
+
+  // Strings with escape sequences, after decoding
+  Arena decoded;
+
+  JsonDocument(MappedFile &&file);
+
+  void build(std::string_view source);
+
+public:
+  // A view of a value in the document. This is only valid as long as the
+  // document is alive
+  class Element {
+  private:
+    const JsonDocument *doc;
+
+    // Index of the node, or -1 for a missing value
+    std::size_t index;
+
+    Element(const JsonDocument *doc, std::size_t index);
+
+    friend class JsonDocument;
+
+  public:
+    JsonValueType getType() const;
+
+    bool isInt() const;
+
+    int64_t asInt() const;
+
+    bool isDouble() const;
+
+    double asDouble() const;
+
+    bool isNull() const;
+
+    bool isString() const;
+
+    std::string_view asString() const;
+
+    bool isBool() const;
+
+    bool asBool() const;
+
+    bool isJson() const;
+
+    bool isList() const;
+
+    // Whether this element is missing from the document
+    bool isNone() const;
+
+    // Number of values in this object or list. This walks the values, like
+    // `at` and `operator[]`
+    std::size_t size() const;
+
+    bool has(std::string_view key) const;
+
+    // Value for the key in this object. If the key is there more than once,
+    // the last one is used, like when parsing a Json. The element is none if
+    // there is no such key
+    Element operator[](std::string_view key) const;
+
+    // Value at the index in this list. The element is none if the index is
+    // out of range. Use `forEachElement` to visit every value of a list
+    Element at(std::size_t index) const;
+
+    // Call `visit` with the key and the element of every member of this
+    // object, in order. Members with the same key are all visited
+    template <typename Visitor> void forEachMember(Visitor &&visit) const {
+      if (!isJson()) {
+        return;
+      }
+      auto &nodes = doc->nodes;
+      for (std::size_t i = index + 1; i < nodes[index].end; i = nodes[i].end) {
+        visit(nodes[i].key, Element(doc, i));
+      }
+    }
+
+    // Call `visit` with the element of every value of this list, in order
+    template <typename Visitor> void forEachElement(Visitor &&visit) const {
+      if (!isList()) {
+        return;
+      }
+      auto &nodes = doc->nodes;
+      for (std::size_t i = index + 1; i < nodes[index].end; i = nodes[i].end) {
+        visit(Element(doc, i));
+      }
+    }
+
+    // Copy this value and everything inside it into a JsonValue
+    JsonValue toJsonValue() const;
+  };
+
+  /**
+   * @brief Create a document by parsing the provided text. Throws
+   * nuo::Exception if the text is not valid
+   *
+   * @param text Json text
+   */
+  JsonDocument(std::string text);
+
+  /**
+   * @brief Create a document from the file at the provided path. The file is
+   * mapped into memory and stays mapped as long as the document is alive.
+   * Throws nuo::Exception if the file could not be read or is not valid
+   *
+   * @param path Path of the file
+   * @return JsonDocument
+   */
+  static JsonDocument fromFile(const std::string &path);
+
+  JsonDocument(JsonDocument const &other) = delete;
+
+  JsonDocument &operator=(JsonDocument const &other) = delete;
+
+  JsonDocument(JsonDocument &&other) noexcept;
+
+  JsonDocument &operator=(JsonDocument &&other) noexcept;
+
+  // The value at the top level
+  Element root() const;
+};
+
+} // namespace nuo
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef NUO_JSON_KEY_HPP
+#define NUO_JSON_KEY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace nuo {
+
+class Json;
+class JsonKeyTable;
+
+// A key of a Json object, interned in a JsonKeyTable. Objects that have the
+// same keys share one copy of each key. Keys interned in the same table are
+// equal only if they are the same entry, so comparing them is comparing two
+// pointers. Keys from different tables are compared by their text
+class JsonKey {
+private:
+  // The entries of a table, which are kept alive by the table and by every
+  // entry in them, so that an entry can remove itself after the table is gone
+  class Table;
+
+  class Entry {
+  public:
+    Entry(std::string_view text, std::shared_ptr<Table> table);
+
+    // One for every key that refers to the entry. The entry is removed from
+    // its table when this reaches zero, which only happens while the table
+    // is locked
+    std::atomic<std::size_t> references;
+
+    std::shared_ptr<Table> table;
+
+    std::size_t hash;
+
+    std::string text;
+  };
+
+  Entry *entry;
+
+  // Refer to the entry, taking a new reference to it
+  JsonKey(Entry *entry);
+
+  // Drop the reference to the entry, and remove it from its table if it was
+  // the last
+  void release() noexcept;
+
+  friend class Json;
+  friend class JsonKeyTable;
+
+public:
+  // An empty handle, which is not equal to any key
+  JsonKey();
+
+  /**
+   * @brief Intern the text in the table that the current thread uses
+   *
+   * @param text Text of the key
+   */
+  explicit JsonKey(std::string_view text);
+
+  JsonKey(const JsonKey &other) noexcept;
+
+  JsonKey(JsonKey &&other) noexcept;
+
+  JsonKey &operator=(const JsonKey &other) noexcept;
+
+  JsonKey &operator=(JsonKey &&other) noexcept;
+
+  ~JsonKey() noexcept;
+
+  const std::string &text() const;
+
+  // Hash of the text, which is the same in every table
+  std::size_t hash() const;
+
+  bool operator==(const JsonKey &other) const;
+
+  bool operator!=(const JsonKey &other) const;
+
+  bool operator==(std::string_view other) const;
+
+  bool operator!=(std::string_view other) const;
+};
+
+// Interns the keys of Json objects. Every thread uses the process wide table,
+// unless a Scope makes it use another one, like a table for one document
+// that is dropped with the document. The table does not keep its entries
+// alive: an entry is removed as soon as the last key for it is dropped, so
+// a table only holds the keys of values that exist. Keys keep their entries
+// alive, so objects can outlive the table that their keys were interned in.
+// Tables can be used from many threads at the same time
+class JsonKeyTable {
+private:
+  std::shared_ptr<JsonKey::Table> table;
+
+public:
+  JsonKeyTable();
+
+  JsonKeyTable(const JsonKeyTable &other) = delete;
+
+  JsonKeyTable &operator=(const JsonKeyTable &other) = delete;
+
+  ~JsonKeyTable() noexcept;
+
+  // The key for the text, which is added to the table if it is not there
+  JsonKey intern(std::string_view text);
+
+  // Whether a key for the text is in the table
+  bool contains(std::string_view text) const;
+
+  // Number of distinct keys in the table, which are all in use
+  std::size_t size() const;
+
+  // The process wide table
+  static JsonKeyTable &global();
+
+  // The table that the current thread uses
+  static JsonKeyTable &current();
+
+  // Makes the current thread use a table until the scope ends. Scopes can be
+  // nested, and the table should outlive the scope
+  class Scope {
+  private:
+    JsonKeyTable *previous;
+
+  public:
+    Scope(JsonKeyTable &table);
+
+    Scope(const Scope &other) = delete;
+
+    Scope &operator=(const Scope &other) = delete;
+
+    ~Scope() noexcept;
+  };
+};
+
+} // namespace nuo
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef NUO_JSON_LINES_HPP
+#define NUO_JSON_LINES_HPP
+
+#include "nuo/json.hpp"
+#include "nuo/json_parser.hpp"
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace nuo {
+
+// Reader for newline delimited Json, also known as JSON Lines, where every
+// line is a Json object. The input is split into batches of lines that are
+// parsed in parallel by a pool of worker threads. Blank lines are skipped
+class JsonLines {
+public:
+  // Receives each parsed record and its line number, starting from 1. This is
+  // always called on the thread that is reading
+  using Consumer = std::function<void(Json &&record, std::size_t line)>;
+
+  /**
+   * @brief Create a reader
+   *
+   * @param workers Number of worker threads. If this is 0, the number of
+   * hardware threads is used
+   * @param batchSize Approximate number of bytes in a batch of lines. Lines
+   * are never split between batches
+   * @param ordered If true, records are provided in the order of the input.
+   * Otherwise records are provided as soon as their batch is parsed, which
+   * keeps the workers busier
+   * @param limits Limits of every line. Lines over the byte limit are
+   * rejected while they are read, before they are buffered completely
+   */
+  JsonLines(unsigned workers = 0, std::size_t batchSize = 1 << 20,
+            bool ordered = true, const JsonLimits &limits = JsonLimits());
+
+  /**
+   * @brief Read all records in the stream. Throws nuo::Exception with the line
+   * number if a line is not valid. Records of earlier batches might already
+   * have been provided when that happens
+   *
+   * @param input The stream to read
+   * @param consumer Function receiving the records
+   */
+  void read(std::istream &input, const Consumer &consumer) const;
+
+  /**
+   * @brief Read all records in the file at the provided path. The file is
+   * mapped into memory, so the lines are not copied before parsing
+   *
+   * @param path Path of the file
+   * @param consumer Function receiving the records
+   */
+  void readFile(const std::string &path, const Consumer &consumer) const;
+
+private:
+  class Batch;
+
+  unsigned workers;
+
+  std::size_t batchSize;
+
+  bool ordered;
+
+  JsonLimits limits;
+
+  // Run the pipeline on the batches provided by `nextBatch`, which returns
+  // false at the end of the input
+  void run(const std::function<bool(Batch &)> &nextBatch,
+           const Consumer &consumer) const;
+};
+
+} // namespace nuo
+
+#endif
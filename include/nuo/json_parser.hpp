@@ -1,9 +1,14 @@
 #ifndef NUO_JSON_PARSER_HPP
 #define NUO_JSON_PARSER_HPP
 
+#include "nuo/exception.hpp"
+#include "nuo/json_key.hpp"
+#include <array>
 #include <cstddef>
-#include <optional>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 namespace nuo {
@@ -11,9 +16,97 @@ namespace nuo {
 class Json;
 class JsonValue;
 
+// Kinds of problems found in Json text
+enum class JsonErrorKind {
+  none,
+  // The text ended inside a string, object or list
+  unexpectedEnd,
+  // A token that is not allowed where it was found
+  unexpectedToken,
+  // A comma that is not followed by another key or value
+  trailingComma,
+  // A character or word that does not begin any token
+  invalidSymbol,
+  invalidNumber,
+  numberOutOfRange,
+  invalidEscape,
+  invalidUtf8,
+  // A byte below 0x20 inside a string, which has to be escaped
+  controlCharacter,
+  // Objects and lists are nested deeper than JsonLimits::maxDepth
+  depthLimit,
+  // The text is larger than JsonLimits::maxBytes
+  sizeLimit,
+  // A key or string is longer than JsonLimits::maxStringLength
+  stringLimit,
+  // The values need more memory than JsonLimits::maxAllocation
+  allocationLimit,
+};
+
+// A problem found in Json text
+class JsonError {
+public:
+  JsonError()
+      : kind(JsonErrorKind::none), offset(0), line(0), column(0), message() {}
+
+  JsonErrorKind kind;
+
+  // Position of the byte where the problem was found
+  std::size_t offset;
+
+  // Line and column of that byte, both starting from 1. Columns are counted
+  // in bytes. These are only set by functions that return the error to users
+  std::size_t line;
+  std::size_t column;
+
+  std::string message;
+
+  // Whether there is a problem
+  bool has() const { return kind != JsonErrorKind::none; }
+
+  // Set the line and column from the offset in the provided text
+  void locate(std::string_view text);
+};
+
+// Bounds on the Json text that a parser accepts, for text from sources that
+// are not trusted. They are checked as each token is parsed, so text over a
+// limit is rejected as soon as the limit is crossed, and before the values
+// beyond it are created. A limit of 0 means there is no limit
+class JsonLimits {
+public:
+  JsonLimits()
+      : maxDepth(0), maxBytes(0), maxStringLength(0), maxAllocation(0) {}
+
+  // Number of objects and lists that can be open at the same time
+  std::size_t maxDepth;
+
+  // Size of the text. Whole texts are checked before parsing begins
+  std::size_t maxBytes;
+
+  // Bytes in a key or string after decoding escape sequences
+  std::size_t maxStringLength;
+
+  // Bytes allocated for the values of a Json tree built from the text. This
+  // is estimated from the size of every key and value, and of the index of
+  // objects with many keys, and does not include the spare capacity of
+  // containers. The text of a key is only counted if the key is not in the
+  // key table yet, since keys share their text
+  std::size_t maxAllocation;
+
+  // Whether any limit is set
+  bool has() const {
+    return (maxDepth != 0) || (maxBytes != 0) || (maxStringLength != 0) ||
+           (maxAllocation != 0);
+  }
+};
+
+// Parser for Json text. Tokens are lexed one at a time and fed to a grammar
+// that keeps the open objects and lists in an explicit stack, so the text is
+// walked exactly once. Everything the grammar recognises is reported to a
+// handler, which either builds a Json tree or consumes the events directly
 class JsonParser {
-private:
-  enum class TokenType {
+public:
+  enum class TokenType : uint8_t {
     False,
     True,
     curlyBraceOpen,
@@ -30,39 +123,460 @@ private:
 
   class Token {
   public:
-    Token(TokenType _type) : type(_type), value() {}
-    Token(TokenType _type, std::string _val) : type(_type), value(_val) {}
+    Token(TokenType _type)
+        : type(_type), value(), view(), offset(0), length(0), integer(0),
+          decimal(0) {}
+    Token(TokenType _type, std::string _val)
+        : type(_type), value(_val), view(value), offset(0), length(0),
+          integer(0), decimal(0) {}
 
     TokenType type;
+
+    // Contents of strings with escape sequences after decoding them
     std::string value;
+
+    // Contents of strings. This is a view into the lexed text if the string
+    // has no escape sequences, and a view of `value` otherwise
+    std::string_view view;
+
+    // Position of the first byte of the token in the lexed text
+    std::size_t offset;
+
+    // Number of bytes of the token in the lexed text
+    std::size_t length;
+
+    // Value of integer tokens
+    int64_t integer;
+
+    // Value of floating point tokens
+    double decimal;
+  };
+
+  /**
+   * @brief Parse the provided text and report its structure to the handler
+   * without building a Json tree. The handler is a template parameter so that
+   * the calls can be inlined, and it needs these member functions:
+   *
+   *     void startObject();
+   *     void endObject();
+   *     void startList();
+   *     void endList();
+   *     void key(std::string_view key);
+   *     void string(std::string_view val);
+   *     void integer(int64_t val);
+   *     void decimal(double val);
+   *     void boolean(bool val);
+   *     void null();
+   *
+   * The views passed to `key` and `string` are only valid during the call.
+   * Any value can be at the top level, and the text can contain several top
+   * level values one after another. Memory used by the parser only depends on
+   * the nesting depth of the text. Throws nuo::Exception for invalid text, or
+   * for text over the limits
+   *
+   * @param text The Json text to parse
+   * @param handler The handler receiving the events
+   * @param limits Limits of the text. The allocation limit applies to the
+   * tree that would be built from the text
+   */
+  template <typename Handler>
+  static void sax(std::string_view text, Handler &handler,
+                  const JsonLimits &limits = JsonLimits()) {
+    auto parser = JsonParser(false, limits);
+    if (!parser.run(text, handler)) {
+      throw Exception(parser.error.message);
+    }
+  }
+
+  // Every token of a text, stored as parallel arrays so that a token takes 13
+  // bytes and nothing is allocated per token. Brackets know the position of
+  // their matching bracket, so a value of any size is skipped in one step
+  class Tape {
+  public:
+    std::vector<TokenType> types;
+
+    // Position of the first byte of each token in the text
+    std::vector<uint32_t> offsets;
+
+    // Number of bytes of each token in the text
+    std::vector<uint32_t> lengths;
+
+    // Index of the matching bracket for brackets, and of the token itself
+    // for every other token
+    std::vector<uint32_t> matches;
+
+    std::size_t size() const;
+
+    // Index of the token after the value beginning at `token`
+    std::size_t skip(std::size_t token) const;
+
+    // Text of the value beginning at `token`
+    std::string_view source(std::string_view text, std::size_t token) const;
   };
 
-  std::vector<Token> toks;
+  /**
+   * @brief Validate the text and record all of its tokens. The text has the
+   * same rules as in `sax`. Throws nuo::Exception for invalid text, or if the
+   * text is larger than 4 GiB
+   *
+   * @param text The Json text to lex
+   * @return Tape
+   */
+  static Tape lex(std::string_view text);
+
+  /**
+   * @brief Parse text that has a single list at the top level, using several
+   * threads for large texts. The elements are found with a pass over the
+   * structural index, and contiguous runs of elements are parsed concurrently
+   * and then joined in order. Throws nuo::Exception for invalid text, or if
+   * the top level value is not a list
+   *
+   * @param text The Json text to parse
+   * @param workers Number of threads to use. If this is 0, the number of
+   * hardware threads is used
+   */
+  static std::vector<JsonValue> parseList(std::string_view text,
+                                          unsigned workers = 0);
 
 private:
+  // What the grammar expects to see next in the innermost open container
+  enum class Expect {
+    key,
+    keyOrClose,
+    colon,
+    value,
+    valueOrClose,
+    separator,
+  };
+
+  class TreeBuilder;
+
+  // Keys that were interned recently, by their hash, so that the key table is
+  // not locked for every key when texts repeat their keys. A thread that
+  // parses many texts keeps one cache for all of them. Keys are interned in
+  // the table of the current thread, which should not change while the cache
+  // is used
+  class KeyCache {
+  private:
+    std::array<JsonKey, 64> keys;
+
+  public:
+    KeyCache();
+
+    const JsonKey &intern(std::string_view key);
+  };
+
+  // Structural index of Json text, which is the first stage of lexing. It has
+  // the positions of structural characters and quotes outside strings, and of
+  // the first byte of every number or literal. Blocks of 64 bytes are
+  // classified at a time using AVX2 or SSE4.2 if the processor supports them.
+  // The text is indexed one window at a time, so the memory used does not
+  // depend on the size of the text
+  class Index {
+  public:
+    Index(std::string_view text);
+
+    std::string_view text;
+
+    // Start indexing another text
+    void reset(std::string_view text);
+
+    // Continue from `pos` in the text, which has to be the first byte of a
+    // token. Positions in the current window are found again without
+    // indexing anything
+    void seek(std::size_t pos);
+
+    // Get the position of the next indexed character. Returns false at the
+    // end of the text
+    bool next(std::size_t &pos);
+
+  private:
+    static constexpr std::size_t windowSize = 1 << 16;
+
+    // Positions in the current window, relative to `base`
+    std::vector<uint32_t> positions;
+    std::size_t current;
+    std::size_t base;
+
+    // Number of bytes of the text that have been indexed
+    std::size_t indexed;
+
+    // State carried over from the previous block
+    uint64_t inString;
+    uint64_t oddBackslash;
+    uint64_t scalarCarry;
+
+    void fill();
+
+  public:
+    // Problem found by the lexer, which stops lexing
+    JsonError error;
+  };
+
+  // Kinds of the open containers from the outermost one. true is for lists
+  std::vector<bool> open;
+
+  Expect expect;
+
+  // Description of the last completed value, used in error messages
+  const char *lastValue;
+
+  // Whether only objects are allowed at the top level, like in Json text
+  bool objectRoot;
+
+  // Problem found by the grammar, which stops parsing
+  JsonError error;
+
+  JsonLimits limits;
+
+  // Whether any limit is set. Tokens are only checked if one is
+  bool limited;
+
+  // Estimated bytes allocated for the values so far, if there is an
+  // allocation limit
+  std::size_t allocated;
+
+  // Texts of the keys that have been counted in `allocated`, since a key
+  // that is repeated shares its text
+  std::unordered_set<std::string> countedKeys;
+
+  // Keys and index slots of an open object, which are counted in `allocated`
+  // for objects with enough keys to have an index
+  class ObjectSize {
+  public:
+    ObjectSize() : keys(0), slots(0) {}
+
+    std::size_t keys;
+    std::size_t slots;
+  };
+
+  // Sizes of the open objects, if there is an allocation limit
+  std::vector<ObjectSize> objects;
+
   friend class Json;
+  friend class JsonCursor;
+  friend class JsonLines;
+  friend class JsonPointer;
+  friend class JsonReader;
+  friend class LazyJson;
+
+  JsonParser(bool objectRoot, const JsonLimits &limits = JsonLimits());
+
+  // Record a problem in `error`. Always returns false, so that it can be
+  // returned directly
+  static bool fail(JsonError &error, JsonErrorKind kind, std::size_t offset,
+                   std::string message);
+
+  // Lex the token at the next indexed position into `tok`. Returns false if
+  // there are no more tokens, or if the text is not valid. The problem is in
+  // the error of the index in that case
+  static bool lexNext(Index &index, Token &tok);
+
+  // Parse the text into a Json object
+  static Json parse(std::string_view val);
 
-  void lex(std::string val);
+  // Parse the text into a Json object without throwing. Returns false if the
+  // text is not valid, with the problem and its location in `error`
+  static bool tryParse(std::string_view val, Json &result, JsonError &error,
+                       const JsonLimits &limits = JsonLimits());
 
-  Json parse(std::size_t from = -1, std::size_t to = -1) const;
+  // Same as above, with keys interned through the cache of the calling thread
+  static bool tryParse(std::string_view val, Json &result, JsonError &error,
+                       const JsonLimits &limits, KeyCache &keys);
 
-  JsonValue parseValue(std::size_t from, std::size_t to) const;
+  // Parse text with a single value of any type
+  static JsonValue parseValue(std::string_view val);
 
-  std::vector<std::pair<std::string, JsonValue>>
-  parsePairs(std::size_t from, std::size_t to) const;
+  // Lex the text into a tape. If `objectRoot` is true, the text has the same
+  // rules as Json text
+  static Tape lex(std::string_view text, bool objectRoot);
 
-  std::optional<std::size_t>
-  getPairEnd(const bool isList, const std::size_t from,
-             const std::optional<std::size_t> to) const;
+  // Parse the elements of a list, separated by commas, without the brackets.
+  // Returns false if the elements are not valid
+  static bool parseElements(std::string_view val,
+                            std::vector<JsonValue> &result, KeyCache &keys);
 
-  bool isNext(TokenType type, std::size_t current) const;
+  // Handle a token that is not allowed outside Json scope. Returns false if
+  // the token is not ignored
+  bool rejectRoot(const Token &tok);
 
-  bool hasPrimaryCommas(std::size_t from, std::size_t to) const;
+  // Check that no object or list is still open at the end of the text, at
+  // position `end`
+  bool finish(std::size_t end);
 
-  std::vector<std::size_t> getPrimaryCommas(std::size_t from,
-                                            std::size_t to) const;
+  // Check a key or value token against the limits before it is reported.
+  // Returns false if a limit is crossed
+  bool checkLimits(const Token &tok, bool isKey);
+
+  // Feed a token to the grammar. Returns false if the token is not allowed,
+  // with the problem in `error`
+  template <typename Handler> bool push(Token &tok, Handler &handler);
+
+  // Feed every token of the text to the grammar. Returns false if the text is
+  // not valid, with the problem in `error`
+  template <typename Handler> bool run(std::string_view text, Handler &handler);
 };
 
+template <typename Handler>
+bool JsonParser::run(std::string_view text, Handler &handler) {
+  if ((limits.maxBytes != 0) && (text.size() > limits.maxBytes)) {
+    return fail(error, JsonErrorKind::sizeLimit, limits.maxBytes,
+                "Json text is larger than the limit of " +
+                    std::to_string(limits.maxBytes) + " bytes");
+  }
+  auto tok = Token(TokenType::null);
+  auto index = Index(text);
+  while (lexNext(index, tok)) {
+    if (!push(tok, handler)) {
+      return false;
+    }
+  }
+  if (index.error.has()) {
+    error = std::move(index.error);
+    return false;
+  }
+  return finish(text.size());
+}
+
+template <typename Handler>
+bool JsonParser::push(Token &tok, Handler &handler) {
+  if (open.empty()) {
+    if (objectRoot && (tok.type != TokenType::curlyBraceOpen)) {
+      return rejectRoot(tok);
+    }
+    expect = Expect::value;
+  } else {
+    switch (expect) {
+    case Expect::keyOrClose:
+    case Expect::key: {
+      if (tok.type == TokenType::string) {
+        if (limited && !checkLimits(tok, true)) {
+          return false;
+        }
+        handler.key(tok.view);
+        expect = Expect::colon;
+        return true;
+      } else if ((tok.type == TokenType::curlyBraceClose) &&
+                 (expect == Expect::keyOrClose)) {
+        break;
+      } else if (expect == Expect::key) {
+        return fail(error, JsonErrorKind::trailingComma, tok.offset,
+                    "Trailing commas are not allowed. Expected a key after "
+                    "the comma");
+      } else {
+        return fail(error, JsonErrorKind::unexpectedToken, tok.offset,
+                    "Illegal token found inside Json scope");
+      }
+    }
+    case Expect::colon: {
+      if (tok.type != TokenType::colon) {
+        return fail(error, JsonErrorKind::unexpectedToken, tok.offset,
+                    "Colon expected after the key");
+      }
+      expect = Expect::value;
+      return true;
+    }
+    case Expect::separator: {
+      if (tok.type == TokenType::comma) {
+        expect = open.back() ? Expect::value : Expect::key;
+        return true;
+      } else if ((tok.type == TokenType::bracketClose) ||
+                 (tok.type == TokenType::curlyBraceClose)) {
+        break;
+      } else {
+        return fail(error, JsonErrorKind::unexpectedToken, tok.offset,
+                    std::string("Invalid token found after ") + lastValue);
+      }
+    }
+    case Expect::valueOrClose:
+    case Expect::value: {
+      if ((tok.type == TokenType::bracketClose) && open.back() &&
+          (expect == Expect::value)) {
+        return fail(error, JsonErrorKind::trailingComma, tok.offset,
+                    "Trailing commas are not allowed. Expected a value after "
+                    "the comma");
+      }
+      break;
+    }
+    }
+  }
+
+  // The token either closes the innermost container or is a value
+  if (limited && !checkLimits(tok, false)) {
+    return false;
+  }
+  switch (tok.type) {
+  case TokenType::True:
+  case TokenType::False: {
+    handler.boolean(tok.type == TokenType::True);
+    lastValue = "boolean";
+    break;
+  }
+  case TokenType::string: {
+    handler.string(tok.view);
+    lastValue = "string";
+    break;
+  }
+  case TokenType::integer: {
+    handler.integer(tok.integer);
+    lastValue = "integer";
+    break;
+  }
+  case TokenType::floating: {
+    handler.decimal(tok.decimal);
+    lastValue = "floating point number";
+    break;
+  }
+  case TokenType::null: {
+    handler.null();
+    lastValue = "null";
+    break;
+  }
+  case TokenType::curlyBraceOpen: {
+    open.push_back(false);
+    handler.startObject();
+    expect = Expect::keyOrClose;
+    return true;
+  }
+  case TokenType::bracketOpen: {
+    open.push_back(true);
+    handler.startList();
+    expect = Expect::valueOrClose;
+    return true;
+  }
+  case TokenType::curlyBraceClose: {
+    if (open.empty() || open.back() || (expect == Expect::value)) {
+      return fail(error, JsonErrorKind::unexpectedToken, tok.offset,
+                  "Invalid } found");
+    }
+    open.pop_back();
+    handler.endObject();
+    lastValue = "Json object";
+    break;
+  }
+  case TokenType::bracketClose: {
+    if (open.empty() || !open.back()) {
+      return fail(error, JsonErrorKind::unexpectedToken, tok.offset,
+                  "Invalid ] found");
+    }
+    open.pop_back();
+    handler.endList();
+    lastValue = "list";
+    break;
+  }
+  case TokenType::comma: {
+    return fail(error, JsonErrorKind::unexpectedToken, tok.offset,
+                "Invalid , found");
+  }
+  case TokenType::colon: {
+    return fail(error, JsonErrorKind::unexpectedToken, tok.offset,
+                "Invalid : found");
+  }
+  }
+  expect = Expect::separator;
+  return true;
+}
+
 } // namespace nuo
 
-#endif
\ No newline at end of file
+#endif
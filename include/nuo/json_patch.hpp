@@ -0,0 +1,96 @@
+#ifndef NUO_JSON_PATCH_HPP
+#define NUO_JSON_PATCH_HPP
+
+#include "nuo/json.hpp"
+#include "nuo/json_pointer.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nuo {
+
+// A JSON Patch as in RFC 6902, which is a list of operations that change a
+// Json document. Patches are applied directly to the Json tree, and only the
+// values on the path of each operation are visited. Values are moved instead
+// of copied, except by copy operations. If an operation fails, the operations
+// before it are undone, so the document is either fully patched or unchanged
+class JsonPatch {
+public:
+  enum class OperationType { add, remove, replace, move, copy, test };
+
+  class Operation {
+  public:
+    Operation(OperationType type, JsonPointer path, JsonPointer from,
+              JsonValue value);
+
+    OperationType type;
+
+    JsonPointer path;
+
+    // Location of the value to move or copy
+    JsonPointer from;
+
+    // Value to add, replace with, or test against
+    JsonValue value;
+  };
+
+  /**
+   * @brief Create a patch from its Json text, which is a list of operations.
+   * Throws nuo::Exception if the text or any of the operations is not valid
+   *
+   * @param text The patch as Json text
+   */
+  JsonPatch(std::string_view text);
+
+  // These choose the text constructor over the JsonValue one
+  JsonPatch(const char *text) : JsonPatch(std::string_view(text)) {}
+  JsonPatch(const std::string &text) : JsonPatch(std::string_view(text)) {}
+
+  /**
+   * @brief Create a patch from a list of operations. The values of the
+   * operations are moved out of the list. Throws nuo::Exception if the value
+   * is not a list or any of the operations is not valid
+   *
+   * @param patch The patch as a Json list
+   */
+  JsonPatch(JsonValue &&patch);
+
+  JsonPatch(std::vector<Operation> &&operations);
+
+  const std::vector<Operation> &operations() const;
+
+  // The patch as a Json list of operations
+  JsonValue toJsonValue() const;
+
+  // The patch as compact Json text, without any whitespace
+  std::string toString() const;
+
+  /**
+   * @brief Apply the patch to the document. Values are copied from the patch,
+   * so it can be applied again. Throws nuo::Exception if an operation fails,
+   * and leaves the document unchanged in that case
+   *
+   * @param document The document to change
+   */
+  void apply(Json &document) const &;
+
+  /**
+   * @brief Apply the patch to the document, moving the values of the patch
+   * into it. Throws nuo::Exception if an operation fails, and leaves the
+   * document unchanged in that case
+   *
+   * @param document The document to change
+   */
+  void apply(Json &document) &&;
+
+private:
+  class Change;
+  class Editor;
+
+  std::vector<Operation> ops;
+};
+
+} // namespace nuo
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef NUO_JSON_POINTER_HPP
+#define NUO_JSON_POINTER_HPP
+
+#include "nuo/json.hpp"
+#include "nuo/maybe.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nuo {
+
+// A Json Pointer as in RFC 6901, such as `/users/0/name`. It can be evaluated
+// directly on Json text, without parsing anything other than the keys and
+// separators on the way to the value. Values that are not on the way are
+// skipped using the structural index of the parser, and are not allocated or
+// fully validated
+class JsonPointer {
+private:
+  // Reference tokens after unescaping ~0 and ~1
+  std::vector<std::string> tokens;
+
+public:
+  /**
+   * @brief Create a pointer from its string form. An empty string points to
+   * the whole document. Throws nuo::Exception if the pointer is not valid
+   *
+   * @param pointer The pointer, in which every token begins with a /
+   */
+  JsonPointer(std::string_view pointer);
+
+  // Create a pointer from reference tokens that are not escaped
+  JsonPointer(std::vector<std::string> tokens);
+
+  // Number of reference tokens
+  std::size_t size() const;
+
+  // The reference token at the index, after unescaping
+  const std::string &at(std::size_t index) const;
+
+  // The pointer in its string form
+  std::string toString() const;
+
+  /**
+   * @brief Find the text of the value that this pointer refers to. If an
+   * object has the same key more than once, the last one is used, like when
+   * parsing a Json. Throws nuo::Exception if the text on the way to the value
+   * is not valid
+   *
+   * @param text Json text with any value at the top level
+   * @return Maybe<std::string_view> A view into `text`, or null if the value
+   * does not exist
+   */
+  Maybe<std::string_view> find(std::string_view text) const;
+
+  /**
+   * @brief Parse the value that this pointer refers to. Only that value is
+   * parsed. Throws nuo::Exception if the text is not valid
+   *
+   * @param text Json text with any value at the top level
+   * @return JsonValue A none value if the value does not exist
+   */
+  JsonValue get(std::string_view text) const;
+
+  // Whether the token is an index into a list, as a number without leading
+  // zeros. The index is set if it is
+  static bool isIndex(std::string_view token, std::size_t &index);
+};
+
+} // namespace nuo
+
+#endif
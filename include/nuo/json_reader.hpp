@@ -0,0 +1,166 @@
+#ifndef NUO_JSON_READER_HPP
+#define NUO_JSON_READER_HPP
+
+#include "nuo/json.hpp"
+#include "nuo/json_parser.hpp"
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nuo {
+
+// Incremental Json reader. Input can be provided in chunks of any size, and
+// tokens that are split between chunks are resumed when the next chunk
+// arrives. Events and completed values are available as soon as the input
+// containing them has been fed. Any value can be at the top level, and there
+// can be several top level values one after another
+class JsonReader {
+public:
+  enum class EventType {
+    startObject,
+    endObject,
+    startList,
+    endList,
+    key,
+    value,
+  };
+
+  class Event {
+  public:
+    Event() : type(EventType::value), key(), value() {}
+
+    EventType type;
+
+    // The key, if this is a key event
+    std::string key;
+
+    // The value, if this is a value event
+    JsonValue value;
+  };
+
+  /**
+   * @brief Create a reader
+   *
+   * @param limits Limits of the input. The byte limit applies to all input
+   * fed to the reader, and is checked as each chunk arrives. A string that is
+   * split between chunks is rejected once its escaped length alone makes it
+   * too long, so that it is not buffered indefinitely
+   */
+  JsonReader(const JsonLimits &limits = JsonLimits());
+
+  /**
+   * @brief Provide the next chunk of input. The chunk can end anywhere,
+   * including inside a string, number or escape sequence. Throws
+   * nuo::Exception if the input is found to be invalid or over the limits
+   *
+   * @param chunk The next bytes of the input
+   */
+  void feed(std::string_view chunk);
+
+  /**
+   * @brief Mark the end of the input. This completes a number at the very end
+   * of the input, and throws nuo::Exception if a token, object or list is left
+   * incomplete
+   *
+   */
+  void finish();
+
+  /**
+   * @brief Get the next event that is available
+   *
+   * @param event Set to the next event
+   * @return bool false if more input is required for the next event
+   */
+  bool next(Event &event);
+
+  /**
+   * @brief Get the next completed top level value. This consumes events, so
+   * it should not be mixed with calls to `next`
+   *
+   * @param value Set to the completed value
+   * @return bool false if more input is required to complete a value
+   */
+  bool nextValue(JsonValue &value);
+
+private:
+  // Kind of the token that is split between chunks
+  enum class Partial {
+    none,
+    string,
+    number,
+    literal,
+  };
+
+  // Handler queueing the events reported by the grammar
+  class EventQueue {
+  public:
+    std::deque<Event> events;
+
+    void startObject() { add(EventType::startObject); }
+    void endObject() { add(EventType::endObject); }
+    void startList() { add(EventType::startList); }
+    void endList() { add(EventType::endList); }
+    void key(std::string_view key) { add(EventType::key).key = key; }
+    void string(std::string_view val) {
+      add(EventType::value).value = std::string(val);
+    }
+    void integer(int64_t val) { add(EventType::value).value = val; }
+    void decimal(double val) { add(EventType::value).value = val; }
+    void boolean(bool val) { add(EventType::value).value = val; }
+    void null() { add(EventType::value); }
+
+  private:
+    Event &add(EventType type) {
+      events.emplace_back();
+      events.back().type = type;
+      return events.back();
+    }
+  };
+
+  // Object or list being assembled by `nextValue`
+  class Frame {
+  public:
+    Frame(bool _isList) : isList(_isList), object(), list(), key() {}
+
+    bool isList;
+    Json object;
+    std::vector<JsonValue> list;
+    std::string key;
+  };
+
+  JsonParser parser;
+  JsonParser::Token tok;
+  JsonParser::Index index;
+  EventQueue queue;
+  std::vector<Frame> frames;
+
+  // Bytes of the token that is not complete yet
+  std::string pending;
+  Partial partial;
+
+  // Whether the last pending byte of a string began an escape sequence
+  bool isEscape;
+
+  // Number of bytes fed so far
+  std::size_t fed;
+
+  // Number of bytes lexed so far, which is where the pending bytes begin in
+  // the input
+  std::size_t consumed;
+
+  // Index and lex text that ends after a complete token, and hand the tokens
+  // to the grammar
+  void lex(std::string_view text);
+
+  // Throw the error, with its position counted from the start of the input
+  [[noreturn]] void raise(JsonError error) const;
+
+  // Add a value to the innermost frame. Returns true if the value is at the
+  // top level instead, after moving it to `result`
+  bool assemble(JsonValue &&value, JsonValue &result);
+};
+
+} // namespace nuo
+
+#endif
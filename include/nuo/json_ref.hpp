@@ -0,0 +1,109 @@
+#ifndef NUO_JSON_REF_HPP
+#define NUO_JSON_REF_HPP
+
+#include "nuo/json.hpp"
+#include "nuo/json_pointer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace nuo {
+
+// A view of a value in a Json document, which is used to walk the document
+// without copying anything. Walking to a value that does not exist gives a
+// none view instead of throwing, so a path can be followed to the end and
+// checked once. A view is only valid as long as the values on its path are
+// not changed or destroyed
+class JsonRef {
+private:
+  // The value, or null if it is missing or if the view is of an object that
+  // is not in a value
+  const JsonValue *value;
+
+  // The object, if the view is of one
+  const Json *object;
+
+  JsonRef(const JsonValue *value);
+
+public:
+  // A view of the whole document
+  JsonRef(const Json &document);
+
+  JsonRef(const JsonValue &value);
+
+  JsonValueType getType() const;
+
+  bool isInt() const;
+
+  int64_t asInt() const;
+
+  bool isDouble() const;
+
+  double asDouble() const;
+
+  bool isNull() const;
+
+  bool isString() const;
+
+  std::string_view asString() const;
+
+  bool isBool() const;
+
+  bool asBool() const;
+
+  bool isJson() const;
+
+  const Json &asJson() const;
+
+  bool isList() const;
+
+  std::span<const JsonValue> asList() const;
+
+  // Whether the value is missing
+  bool isNone() const;
+
+  // Number of values in this object or list
+  std::size_t size() const;
+
+  bool has(std::string_view key) const;
+
+  // Value for the key in this object. The view is none if there is no such
+  // key
+  JsonRef operator[](std::string_view key) const;
+
+  // Value at the index in this list. The view is none if the index is out of
+  // range
+  JsonRef at(std::size_t index) const;
+
+  /**
+   * @brief Walk the reference tokens of the pointer, as keys in objects and
+   * indices in lists
+   *
+   * @param pointer Path to the value from this view
+   * @return JsonRef None if the value does not exist
+   */
+  JsonRef at(const JsonPointer &pointer) const;
+
+  // Call `visit` with the key and a view of the value of every member of this
+  // object, in order
+  template <typename Visitor> void forEachMember(Visitor &&visit) const {
+    if (!isJson()) {
+      return;
+    }
+    for (std::size_t i = 0; i < object->keys.size(); i++) {
+      if (!object->values[i].isNone()) {
+        visit(std::string_view(object->keys[i].text()),
+              JsonRef(&object->values[i]));
+      }
+    }
+  }
+
+  // Copy the value into a JsonValue. Objects and lists are shared with the
+  // document instead of being copied
+  JsonValue toJsonValue() const;
+};
+
+} // namespace nuo
+
+#endif
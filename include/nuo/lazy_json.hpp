@@ -0,0 +1,89 @@
+#ifndef NUO_LAZY_JSON_HPP
+#define NUO_LAZY_JSON_HPP
+
+#include "nuo/json.hpp"
+#include "nuo/json_parser.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nuo {
+
+// A Json object that is parsed on demand. Creating it only validates the text
+// and records where every token is. The value for a key is parsed into a
+// JsonValue the first time it is accessed, and values that are never accessed
+// are skipped without being allocated. The top level of the text should be a
+// single object
+class LazyJson {
+private:
+  // The text and the position of its tokens, shared by the nested objects
+  class Source {
+  public:
+    Source(std::string text);
+
+    std::string text;
+
+    JsonParser::Tape tape;
+
+    // Whether the key at the token is the provided key
+    bool isKey(std::size_t token, std::string_view key) const;
+  };
+
+  std::shared_ptr<const Source> source;
+
+  // Token index of the value of each key, in order
+  std::vector<uint32_t> members;
+
+  // Values that have been parsed. A none value has not been parsed yet
+  mutable std::vector<JsonValue> values;
+
+  LazyJson(std::shared_ptr<const Source> source, std::size_t start);
+
+  // Position of the key in `members`, or -1 if it is not found
+  std::size_t find(std::string_view key) const;
+
+  JsonValue parseMember(std::size_t pos) const;
+
+public:
+  /**
+   * @brief Validate and index the provided text. Throws nuo::Exception if the
+   * text is not valid
+   *
+   * @param text Json text with an object at the top level
+   */
+  LazyJson(std::string text);
+
+  bool has(std::string_view key) const;
+
+  /**
+   * @brief Get the value for the provided key. It is parsed the first time it
+   * is accessed, and the same value is returned after that. This is not
+   * thread safe, even though it is a const function
+   *
+   * @param key The key to find
+   * @return const JsonValue& A none value if the key is not found
+   */
+  const JsonValue &operator[](std::string_view key) const;
+
+  /**
+   * @brief Get the object for the provided key as another lazy object, without
+   * parsing it. Throws nuo::Exception if the value is not an object
+   *
+   * @param key The key to find
+   * @return LazyJson
+   */
+  LazyJson object(std::string_view key) const;
+
+  // Number of keys in the object. A key that occurs more than once in the
+  // text is counted for each occurence
+  std::size_t size() const;
+
+  // Parse all values in the object
+  Json toJson() const;
+};
+
+} // namespace nuo
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef NUO_MAPPED_FILE_HPP
+#define NUO_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace nuo {
+
+/**
+ * @brief A file mapped into memory for reading. The contents are read by the
+ * operating system as they are accessed, and are not copied into the heap
+ *
+ */
+class MappedFile {
+private:
+  const char *start;
+
+  std::size_t len;
+
+#if PLATFORM_IS_WINDOWS
+  void *file;
+  void *mapping;
+#endif
+
+public:
+  // An empty mapping
+  MappedFile();
+
+  /**
+   * @brief Map the file at the provided path. Throws nuo::Exception if the
+   * file could not be opened or mapped
+   *
+   * @param path Path of the file
+   */
+  MappedFile(const std::string &path);
+
+  MappedFile(MappedFile const &other) = delete;
+
+  MappedFile &operator=(MappedFile const &other) = delete;
+
+  MappedFile(MappedFile &&other) noexcept;
+
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  /**
+   * @brief The contents of the file. This is valid as long as this instance
+   * is alive
+   *
+   * @return std::string_view
+   */
+  std::string_view view() const noexcept;
+
+  std::size_t size() const noexcept;
+
+  void clear() noexcept;
+
+  ~MappedFile() noexcept;
+};
+
+} // namespace nuo
+
+#endif
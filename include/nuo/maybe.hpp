@@ -2,6 +2,7 @@
 #define NUO_MAYBE_HPP
 
 #include "nuo/exception.hpp"
+#include <utility>
 
 namespace nuo {
 
@@ -18,24 +19,16 @@ private:
 
 public:
   // Create a Maybe instance with a value of the associated type
-  Maybe(const T value) : val(new T(value)) {}
+  Maybe(const T &value) : val(new T(value)) {}
+
+  Maybe(T &&value) : val(new T(std::move(value))) {}
 
   // Create a Maybe instance with a null value
   Maybe() : val(nullptr) {}
 
   // Copy constructor for Maybe
-  Maybe(Maybe<T> const &other) {
-    if (val) {
-      if (other.has()) {
-        *((T *)val) = *((T *)other.val);
-      } else {
-        delete ((T *)val);
-        val = nullptr;
-      }
-    } else {
-      val = new T(*((T *)other.val));
-    }
-  }
+  Maybe(Maybe<T> const &other)
+      : val(other.has() ? new T(*((T *)other.val)) : nullptr) {}
 
   // Move constructor for Maybe
   Maybe(Maybe<T> &&other) : val(other.val) { other.val = nullptr; }
@@ -56,7 +49,7 @@ public:
         delete ((T *)val);
         val = nullptr;
       }
-    } else {
+    } else if (other.has()) {
       val = new T(*((T *)other.val));
     }
     return *this;
@@ -0,0 +1,706 @@
+#ifndef NUO_STATIC_JSON_HPP
+#define NUO_STATIC_JSON_HPP
+
+#include "nuo/json.hpp"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+namespace nuo {
+
+// A string literal used as a template argument
+template <std::size_t N> class JsonLiteral {
+public:
+  char chars[N];
+
+  consteval JsonLiteral(const char (&str)[N]) : chars() {
+    for (std::size_t i = 0; i < N; i++) {
+      chars[i] = str[i];
+    }
+  }
+
+  constexpr std::size_t size() const { return N - 1; }
+};
+
+// A value in a static document. Like the nodes of JsonDocument, the values
+// are stored in document order and the values inside an object or list
+// directly follow it. Keys and strings are ranges of the character pool of
+// the document
+class StaticJsonNode {
+public:
+  JsonValueType type = JsonValueType::null;
+
+  // Index of the node after this value and all values inside it
+  uint32_t end = 0;
+
+  uint32_t keyStart = 0;
+  uint32_t keyLength = 0;
+
+  uint32_t stringStart = 0;
+  uint32_t stringLength = 0;
+
+  int64_t integer = 0;
+  double decimal = 0;
+  bool boolean = false;
+};
+
+// Reports an invalid literal. This is not constexpr, so reaching it while a
+// literal is parsed during compilation makes the program ill-formed, and the
+// compiler shows the message. If it is reached at runtime, it throws
+// nuo::Exception
+[[noreturn]] void staticJsonError(const char *message);
+
+// A view of a value in a static document. Every member except toJsonValue is
+// constexpr, and none of them allocate
+class StaticJson {
+private:
+  const StaticJsonNode *nodes;
+  const char *chars;
+
+  // Index of the node, or -1 for a missing value
+  std::size_t index;
+
+  constexpr const StaticJsonNode &node() const { return nodes[index]; }
+
+public:
+  constexpr StaticJson(const StaticJsonNode *nodes, const char *chars,
+                       std::size_t index)
+      : nodes(nodes), chars(chars), index(index) {}
+
+  constexpr JsonValueType getType() const {
+    return isNone() ? JsonValueType::none : node().type;
+  }
+
+  constexpr bool isInt() const { return getType() == JsonValueType::integer; }
+
+  constexpr int64_t asInt() const { return node().integer; }
+
+  constexpr bool isDouble() const {
+    return getType() == JsonValueType::decimal;
+  }
+
+  constexpr double asDouble() const { return node().decimal; }
+
+  constexpr bool isNull() const { return getType() == JsonValueType::null; }
+
+  constexpr bool isString() const {
+    return getType() == JsonValueType::string;
+  }
+
+  constexpr std::string_view asString() const {
+    return std::string_view(chars + node().stringStart, node().stringLength);
+  }
+
+  constexpr bool isBool() const { return getType() == JsonValueType::boolean; }
+
+  constexpr bool asBool() const { return node().boolean; }
+
+  constexpr bool isJson() const { return getType() == JsonValueType::json; }
+
+  constexpr bool isList() const { return getType() == JsonValueType::list; }
+
+  // Whether this value is missing from the document
+  constexpr bool isNone() const { return index == (std::size_t)-1; }
+
+  // Key of this value, if it is inside an object
+  constexpr std::string_view key() const {
+    return isNone() ? std::string_view()
+                    : std::string_view(chars + node().keyStart,
+                                       node().keyLength);
+  }
+
+  // Number of values in this object or list
+  constexpr std::size_t size() const {
+    if (!isJson() && !isList()) {
+      return 0;
+    }
+    std::size_t result = 0;
+    for (std::size_t i = index + 1; i < node().end; i = nodes[i].end) {
+      result++;
+    }
+    return result;
+  }
+
+  constexpr bool has(std::string_view key) const {
+    return !(*this)[key].isNone();
+  }
+
+  // Value for the key in this object. If the key is there more than once, the
+  // last one is used, like when parsing a Json. The value is none if there is
+  // no such key
+  constexpr StaticJson operator[](std::string_view key) const {
+    std::size_t found = -1;
+    if (isJson()) {
+      for (std::size_t i = index + 1; i < node().end; i = nodes[i].end) {
+        if (StaticJson(nodes, chars, i).key() == key) {
+          found = i;
+        }
+      }
+    }
+    return StaticJson(nodes, chars, found);
+  }
+
+  // Value at the index in this list. The value is none if the index is out
+  // of range
+  constexpr StaticJson at(std::size_t pos) const {
+    if (isList()) {
+      for (std::size_t i = index + 1; i < node().end; i = nodes[i].end) {
+        if (pos == 0) {
+          return StaticJson(nodes, chars, i);
+        }
+        pos--;
+      }
+    }
+    return StaticJson(nodes, chars, -1);
+  }
+
+  // Copy this value and everything inside it into a JsonValue. Unlike the
+  // rest of the view, this allocates
+  JsonValue toJsonValue() const;
+};
+
+// Parses Json text in a constant expression. Without output arrays, it only
+// counts the nodes and characters that the text needs, so that the document
+// can be sized before it is built
+class StaticJsonParser {
+private:
+  const char *text;
+  std::size_t length;
+  std::size_t pos;
+
+  StaticJsonNode *nodes;
+  char *chars;
+
+  constexpr bool atEnd() const { return pos >= length; }
+
+  constexpr char peek() const { return atEnd() ? '\0' : text[pos]; }
+
+  constexpr void skipSpace() {
+    while (!atEnd() && (text[pos] == ' ' || text[pos] == '\n' ||
+                        text[pos] == '\r' || text[pos] == '\t')) {
+      pos++;
+    }
+  }
+
+  constexpr void expect(char ch) {
+    skipSpace();
+    if (peek() != ch) {
+      staticJsonError("Unexpected token in json literal");
+    }
+    pos++;
+  }
+
+  constexpr void put(char ch) {
+    if (chars) {
+      chars[charCount] = ch;
+    }
+    charCount++;
+  }
+
+  constexpr void putCodePoint(uint32_t code) {
+    if (code < 0x80) {
+      put((char)code);
+    } else if (code < 0x800) {
+      put((char)(0xC0 | (code >> 6)));
+      put((char)(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+      put((char)(0xE0 | (code >> 12)));
+      put((char)(0x80 | ((code >> 6) & 0x3F)));
+      put((char)(0x80 | (code & 0x3F)));
+    } else {
+      put((char)(0xF0 | (code >> 18)));
+      put((char)(0x80 | ((code >> 12) & 0x3F)));
+      put((char)(0x80 | ((code >> 6) & 0x3F)));
+      put((char)(0x80 | (code & 0x3F)));
+    }
+  }
+
+  constexpr uint32_t hex4() {
+    uint32_t result = 0;
+    for (int i = 0; i < 4; i++, pos++) {
+      char ch = peek();
+      result <<= 4;
+      if (ch >= '0' && ch <= '9') {
+        result |= ch - '0';
+      } else if (ch >= 'a' && ch <= 'f') {
+        result |= ch - 'a' + 10;
+      } else if (ch >= 'A' && ch <= 'F') {
+        result |= ch - 'A' + 10;
+      } else {
+        staticJsonError("Invalid unicode escape in json literal");
+      }
+    }
+    return result;
+  }
+
+  // Copies one UTF-8 encoded character that is not ASCII
+  constexpr void utf8() {
+    auto lead = (unsigned char)text[pos];
+    std::size_t count = 0;
+    uint32_t code = 0;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      count = 1;
+      code = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      count = 2;
+      code = lead & 0x0F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      count = 3;
+      code = lead & 0x07;
+    } else {
+      staticJsonError("Invalid UTF-8 in json literal");
+    }
+    put(text[pos++]);
+    for (std::size_t i = 0; i < count; i++, pos++) {
+      auto ch = (unsigned char)peek();
+      if ((ch & 0xC0) != 0x80) {
+        staticJsonError("Invalid UTF-8 in json literal");
+      }
+      code = (code << 6) | (ch & 0x3F);
+      put(text[pos]);
+    }
+    if ((count == 2 && (code < 0x800 || (code >= 0xD800 && code <= 0xDFFF))) ||
+        (count == 3 && (code < 0x10000 || code > 0x10FFFF))) {
+      staticJsonError("Invalid UTF-8 in json literal");
+    }
+  }
+
+  // Decodes a string into the character pool, and returns where it starts
+  constexpr uint32_t string() {
+    expect('"');
+    auto start = (uint32_t)charCount;
+    while (true) {
+      if (atEnd()) {
+        staticJsonError("Unterminated string in json literal");
+      }
+      auto ch = (unsigned char)text[pos];
+      if (ch == '"') {
+        pos++;
+        return start;
+      } else if (ch < 0x20) {
+        staticJsonError("Control character in json literal string");
+      } else if (ch >= 0x80) {
+        utf8();
+      } else if (ch != '\\') {
+        put(text[pos++]);
+      } else {
+        pos++;
+        char escape = peek();
+        pos++;
+        switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+          put(escape);
+          break;
+        case 'b':
+          put('\b');
+          break;
+        case 'f':
+          put('\f');
+          break;
+        case 'n':
+          put('\n');
+          break;
+        case 'r':
+          put('\r');
+          break;
+        case 't':
+          put('\t');
+          break;
+        case 'u': {
+          auto code = hex4();
+          if (code >= 0xDC00 && code <= 0xDFFF) {
+            staticJsonError("Invalid unicode escape in json literal");
+          }
+          if (code >= 0xD800 && code <= 0xDBFF) {
+            if (peek() != '\\' || pos + 1 >= length || text[pos + 1] != 'u') {
+              staticJsonError("Invalid unicode escape in json literal");
+            }
+            pos += 2;
+            auto low = hex4();
+            if (low < 0xDC00 || low > 0xDFFF) {
+              staticJsonError("Invalid unicode escape in json literal");
+            }
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+          }
+          putCodePoint(code);
+          break;
+        }
+        default:
+          staticJsonError("Invalid escape sequence in json literal");
+        }
+      }
+    }
+  }
+
+  // An unsigned integer large enough for the exact conversion of any number
+  // that a literal is allowed to have
+  class BigInt {
+  public:
+    static constexpr std::size_t limbCount = 128;
+
+    uint32_t limbs[limbCount] = {};
+
+    constexpr bool isZero() const {
+      for (auto limb : limbs) {
+        if (limb != 0) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    constexpr std::size_t bits() const {
+      for (std::size_t i = limbCount; i > 0; i--) {
+        if (limbs[i - 1] != 0) {
+          std::size_t result = (i - 1) * 32;
+          for (auto limb = limbs[i - 1]; limb != 0; limb >>= 1) {
+            result++;
+          }
+          return result;
+        }
+      }
+      return 0;
+    }
+
+    constexpr void multiplyAdd(uint32_t factor, uint32_t addend) {
+      uint64_t carry = addend;
+      for (auto &limb : limbs) {
+        carry += (uint64_t)limb * factor;
+        limb = (uint32_t)carry;
+        carry >>= 32;
+      }
+    }
+
+    constexpr void shiftLeft(std::size_t count) {
+      for (; count >= 32; count -= 32) {
+        for (std::size_t i = limbCount - 1; i > 0; i--) {
+          limbs[i] = limbs[i - 1];
+        }
+        limbs[0] = 0;
+      }
+      if (count > 0) {
+        for (std::size_t i = limbCount - 1; i > 0; i--) {
+          limbs[i] = (limbs[i] << count) | (limbs[i - 1] >> (32 - count));
+        }
+        limbs[0] <<= count;
+      }
+    }
+
+    constexpr void shiftRightOne() {
+      for (std::size_t i = 0; i + 1 < limbCount; i++) {
+        limbs[i] = (limbs[i] >> 1) | (limbs[i + 1] << 31);
+      }
+      limbs[limbCount - 1] >>= 1;
+    }
+
+    constexpr bool operator>=(const BigInt &other) const {
+      for (std::size_t i = limbCount; i > 0; i--) {
+        if (limbs[i - 1] != other.limbs[i - 1]) {
+          return limbs[i - 1] > other.limbs[i - 1];
+        }
+      }
+      return true;
+    }
+
+    constexpr void subtract(const BigInt &other) {
+      uint64_t borrow = 0;
+      for (std::size_t i = 0; i < limbCount; i++) {
+        auto diff = (uint64_t)limbs[i] - other.limbs[i] - borrow;
+        limbs[i] = (uint32_t)diff;
+        borrow = (diff >> 32) & 1;
+      }
+    }
+  };
+
+  // The closest double to digits * 10^exponent, rounding halfway cases to
+  // even like std::from_chars does
+  static constexpr double toDouble(BigInt digits, int exponent) {
+    BigInt divisor;
+    divisor.limbs[0] = 1;
+    for (; exponent > 0; exponent--) {
+      digits.multiplyAdd(10, 0);
+    }
+    for (; exponent < 0; exponent++) {
+      divisor.multiplyAdd(10, 0);
+    }
+    // Scale so that the quotient has 63 or 64 bits
+    int shift = 63 - ((int)digits.bits() - (int)divisor.bits());
+    if (shift > 0) {
+      digits.shiftLeft(shift);
+    } else {
+      divisor.shiftLeft(-shift);
+    }
+    divisor.shiftLeft(63);
+    uint64_t quotient = 0;
+    for (int bit = 63; bit >= 0; bit--) {
+      if (digits >= divisor) {
+        digits.subtract(divisor);
+        quotient |= (uint64_t)1 << bit;
+      }
+      divisor.shiftRightOne();
+    }
+    bool sticky = !digits.isZero();
+    int length = 64;
+    while (!((quotient >> (length - 1)) & 1)) {
+      length--;
+    }
+    // The value is in [2^power, 2^(power + 1))
+    int power = length - 1 - shift;
+    int precision = power >= -1022 ? 53 : 53 - (-1022 - power);
+    int drop = length - precision;
+    uint64_t kept = drop >= 64 ? 0 : quotient >> drop;
+    bool half = drop >= 1 && drop <= 64 && ((quotient >> (drop - 1)) & 1);
+    // Whether anything below the half bit is set
+    bool rest = sticky;
+    if (drop >= 65) {
+      rest = rest || quotient != 0;
+    } else if (drop >= 2) {
+      rest = rest || (quotient & (((uint64_t)1 << (drop - 1)) - 1)) != 0;
+    }
+    if (half && (rest || (kept & 1))) {
+      kept++;
+    }
+    uint64_t bits = 0;
+    if (power < -1022) {
+      // Rounding up to the smallest normal value sets the exponent bit
+      bits = kept;
+    } else {
+      if (kept >> 53) {
+        kept >>= 1;
+        power++;
+      }
+      if (power > 1023) {
+        staticJsonError("Number is out of range in json literal");
+      }
+      bits = ((uint64_t)(power + 1023) << 52) |
+             (kept & (((uint64_t)1 << 52) - 1));
+    }
+    return std::bit_cast<double>(bits);
+  }
+
+  // Parses a number with the same grammar, the same choice between integer
+  // and decimal, and the same rounding as the runtime parser. from_chars is
+  // not usable in constant expressions, so decimals are converted exactly
+  // with big integers
+  constexpr void number(StaticJsonNode &node) {
+    bool negative = false;
+    if (peek() == '-') {
+      negative = true;
+      pos++;
+    }
+    if (peek() < '0' || peek() > '9') {
+      staticJsonError("Invalid number in json literal");
+    }
+    BigInt digits;
+    int significant = 0;
+    int exponent = 0;
+    auto digit = [&](char ch) {
+      if (significant > 0 || ch != '0') {
+        if (++significant > 800) {
+          staticJsonError("Too many digits in json literal number");
+        }
+        digits.multiplyAdd(10, ch - '0');
+      }
+    };
+    uint64_t magnitude = 0;
+    std::size_t intDigits = 0;
+    if (peek() == '0') {
+      pos++;
+      intDigits = 1;
+      if (peek() >= '0' && peek() <= '9') {
+        staticJsonError("Invalid number in json literal");
+      }
+    } else {
+      while (peek() >= '0' && peek() <= '9') {
+        magnitude = magnitude * 10 + (text[pos] - '0');
+        intDigits++;
+        digit(text[pos++]);
+      }
+    }
+    bool onlyZeroes = true;
+    if (peek() == '.') {
+      pos++;
+      if (peek() < '0' || peek() > '9') {
+        staticJsonError("Invalid number in json literal");
+      }
+      while (peek() >= '0' && peek() <= '9') {
+        onlyZeroes = onlyZeroes && text[pos] == '0';
+        exponent--;
+        digit(text[pos++]);
+      }
+    }
+    bool hasExponent = false;
+    if (peek() == 'e' || peek() == 'E') {
+      hasExponent = true;
+      pos++;
+      bool negativeExponent = false;
+      if (peek() == '+' || peek() == '-') {
+        negativeExponent = peek() == '-';
+        pos++;
+      }
+      if (peek() < '0' || peek() > '9') {
+        staticJsonError("Invalid number in json literal");
+      }
+      int value = 0;
+      while (peek() >= '0' && peek() <= '9') {
+        value = value < 100000 ? value * 10 + (text[pos] - '0') : value;
+        pos++;
+      }
+      exponent += negativeExponent ? -value : value;
+    }
+    // Up to 19 digits cannot overflow uint64_t, so only the sign is checked
+    if (onlyZeroes && !hasExponent && intDigits <= 19) {
+      auto limit = (uint64_t)std::numeric_limits<int64_t>::max() + negative;
+      if (magnitude <= limit) {
+        node.type = JsonValueType::integer;
+        node.integer =
+            negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+        return;
+      }
+    }
+    node.type = JsonValueType::decimal;
+    double result = 0;
+    // The value is below 10^(significant + exponent). Values that are out of
+    // range, or too small to be represented, are decided before converting
+    if (!digits.isZero() && significant + exponent > 310) {
+      staticJsonError("Number is out of range in json literal");
+    } else if (!digits.isZero() && significant + exponent >= -330) {
+      result = toDouble(digits, exponent);
+    }
+    node.decimal = negative ? -result : result;
+  }
+
+  constexpr void literal(std::string_view word) {
+    if (std::string_view(text + pos, length - pos).substr(0, word.size()) !=
+        word) {
+      staticJsonError("Invalid symbol in json literal");
+    }
+    pos += word.size();
+  }
+
+  constexpr void value(uint32_t keyStart, uint32_t keyLength) {
+    skipSpace();
+    StaticJsonNode node;
+    node.keyStart = keyStart;
+    node.keyLength = keyLength;
+    auto self = nodeCount++;
+    char ch = peek();
+    if (ch == '{' || ch == '[') {
+      pos++;
+      node.type = ch == '{' ? JsonValueType::json : JsonValueType::list;
+      char close = ch == '{' ? '}' : ']';
+      skipSpace();
+      if (peek() == close) {
+        pos++;
+      } else {
+        while (true) {
+          if (ch == '{') {
+            auto start = string();
+            auto keyEnd = (uint32_t)charCount;
+            expect(':');
+            value(start, keyEnd - start);
+          } else {
+            value(0, 0);
+          }
+          skipSpace();
+          if (peek() == ',') {
+            pos++;
+          } else if (peek() == close) {
+            pos++;
+            break;
+          } else {
+            staticJsonError("Unexpected token in json literal");
+          }
+        }
+      }
+    } else if (ch == '"') {
+      node.type = JsonValueType::string;
+      node.stringStart = string();
+      node.stringLength = (uint32_t)charCount - node.stringStart;
+    } else if (ch == 't') {
+      literal("true");
+      node.type = JsonValueType::boolean;
+      node.boolean = true;
+    } else if (ch == 'f') {
+      literal("false");
+      node.type = JsonValueType::boolean;
+    } else if (ch == 'n') {
+      literal("null");
+    } else if (ch == '-' || (ch >= '0' && ch <= '9')) {
+      number(node);
+    } else if (atEnd()) {
+      staticJsonError("Unexpected end of json literal");
+    } else {
+      staticJsonError("Unexpected token in json literal");
+    }
+    node.end = (uint32_t)nodeCount;
+    if (nodes) {
+      nodes[self] = node;
+    }
+  }
+
+public:
+  std::size_t nodeCount;
+  std::size_t charCount;
+
+  constexpr StaticJsonParser(std::string_view text,
+                             StaticJsonNode *nodes = nullptr,
+                             char *chars = nullptr)
+      : text(text.data()), length(text.size()), pos(0), nodes(nodes),
+        chars(chars), nodeCount(0), charCount(0) {}
+
+  // Parses the whole text as one value of any type
+  constexpr void parse() {
+    value(0, 0);
+    skipSpace();
+    if (!atEnd()) {
+      staticJsonError("Unexpected token after the value in json literal");
+    }
+  }
+};
+
+// The storage of a static document, sized by a counting pass over the text
+template <std::size_t Nodes, std::size_t Chars> class StaticJsonData {
+public:
+  std::array<StaticJsonNode, Nodes> nodes;
+  std::array<char, Chars> chars;
+
+  constexpr StaticJson root() const {
+    return StaticJson(nodes.data(), chars.data(), 0);
+  }
+};
+
+template <JsonLiteral L> class StaticJsonStorage {
+private:
+  static constexpr auto counts = [] {
+    auto parser = StaticJsonParser(std::string_view(L.chars, L.size()));
+    parser.parse();
+    return std::array<std::size_t, 2>{parser.nodeCount, parser.charCount};
+  }();
+
+public:
+  // One immutable document for each distinct literal in the program
+  static constexpr auto data = [] {
+    StaticJsonData<counts[0], counts[1]> result{};
+    auto parser = StaticJsonParser(std::string_view(L.chars, L.size()),
+                                   result.nodes.data(), result.chars.data());
+    parser.parse();
+    return result;
+  }();
+};
+
+} // namespace nuo
+
+// Json parsed during compilation. Invalid text fails to compile, and the
+// document is a constant in static storage, so using it does not parse or
+// allocate at runtime
+template <nuo::JsonLiteral L> constexpr nuo::StaticJson operator""_cjson() {
+  return nuo::StaticJsonStorage<L>::data.root();
+}
+
+#endif
@@ -51,7 +51,9 @@ public:
    *
    * @param value Value of the associated type
    */
-  Vague(T _value) : value(_value), problem() {}
+  Vague(const T &_value) : value(_value), problem() {}
+
+  Vague(T &&_value) : value(std::move(_value)), problem() {}
 
   // Create a Vague instance with a Problem
   Vague(Problem _problem) : value(), problem(_problem) {}
@@ -60,21 +62,8 @@ public:
   Vague(const Vague &other) : value(other.value), problem(other.problem) {}
 
   // Move constructor for Vague
-  Vague(Vague &&other) : value(other.value), problem(other.problem) {
-    other.value = Null();
-    other.problem = Null();
-  }
-
-  ~Vague() noexcept {
-    if (has()) {
-      value.get().~T();
-      value = Null();
-    }
-    if (hasProblem()) {
-      problem.get().~Problem();
-      problem = Null();
-    }
-  }
+  Vague(Vague &&other)
+      : value(std::move(other.value)), problem(std::move(other.problem)) {}
 
   // Assign reference to another const Vague instance
   void operator=(const Vague<T> &other) {
@@ -4,6 +4,8 @@
 #include "nuo/maybe.hpp"
 #include <cstddef>
 #include <initializer_list>
+#include <new>
+#include <utility>
 
 namespace nuo {
 
@@ -65,7 +67,7 @@ public:
   Vec(Vec<T> const &other) : start(nullptr), len(0), buff_len(0) {
     start = allocate_space(other.len);
     for (unsigned i = 0; i < other.len; i++) {
-      start[i] = other.at(i).get();
+      new (start + i) T(other.start[i]);
     }
     len = other.len;
     buff_len = len;
@@ -95,7 +97,7 @@ public:
     buff_len = len;
     unsigned i = 0;
     for (const auto &elem : list) {
-      start[i] = elem;
+      new (start + i) T(elem);
       i++;
     }
   }
@@ -199,12 +201,13 @@ public:
       buff_len = 2 * ((buff_len > 0) ? buff_len : 1);
       auto new_start = allocate_space(buff_len);
       for (unsigned i = 0; i < len; i++) {
-        new_start[i] = start[i];
+        new (new_start + i) T(std::move(start[i]));
+        start[i].~T();
       }
       free_space();
       start = new_start;
     }
-    start[len] = element;
+    new (start + len) T(std::move(element));
     len++;
   }
 
@@ -388,10 +391,10 @@ public:
    *
    */
   void operator=(const Vec<T> &other) noexcept {
-    free_space();
+    clear();
     start = allocate_space(other.len);
-    for (unsigned i = 0; i < len; i++) {
-      start[i] = other.at(i).get();
+    for (unsigned i = 0; i < other.len; i++) {
+      new (start + i) T(other.start[i]);
     }
     len = other.len;
     buff_len = len;
@@ -403,6 +406,7 @@ public:
    * @param other Other value
    */
   void operator=(Vec<T> &&other) noexcept {
+    clear();
     start = other.start;
     len = other.len;
     buff_len = other.buff_len;
@@ -0,0 +1,98 @@
+#include "nuo/arena.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace nuo {
+
+namespace {
+
+// Blocks stop growing at this size, so that a small arena is not left with a
+// huge unused tail
+constexpr std::size_t maxBlockSize = 1 << 24;
+
+} // namespace
+
+Arena::Arena(std::size_t initialBlockSize)
+    : head(nullptr), cursor(nullptr), limit(nullptr),
+      blockSize(initialBlockSize ? initialBlockSize : 1), used(0) {}
+
+Arena::Arena(Arena &&other) noexcept
+    : head(other.head), cursor(other.cursor), limit(other.limit),
+      blockSize(other.blockSize), used(other.used) {
+  other.head = nullptr;
+  other.cursor = nullptr;
+  other.limit = nullptr;
+  other.used = 0;
+}
+
+Arena &Arena::operator=(Arena &&other) noexcept {
+  if (this != &other) {
+    clear();
+    head = other.head;
+    cursor = other.cursor;
+    limit = other.limit;
+    blockSize = other.blockSize;
+    used = other.used;
+    other.head = nullptr;
+    other.cursor = nullptr;
+    other.limit = nullptr;
+    other.used = 0;
+  }
+  return *this;
+}
+
+void Arena::grow(std::size_t size) {
+  auto capacity = (size > blockSize) ? size : blockSize;
+  if (blockSize < maxBlockSize) {
+    blockSize *= 2;
+  }
+  auto block = (Block *)std::malloc(sizeof(Block) + capacity);
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  block->previous = head;
+  block->size = capacity;
+  head = block;
+  cursor = (char *)(block + 1);
+  limit = cursor + capacity;
+}
+
+void *Arena::allocate(std::size_t size, std::size_t align) {
+  auto aligned = [&]() {
+    return (char *)(((uintptr_t)cursor + (align - 1)) & ~(uintptr_t)(align - 1));
+  };
+  if ((cursor == nullptr) || (aligned() + size > limit)) {
+    grow(size + align);
+  }
+  auto result = aligned();
+  cursor = result + size;
+  used += size;
+  return result;
+}
+
+std::string_view Arena::copy(std::string_view val) {
+  if (val.empty()) {
+    return std::string_view();
+  }
+  auto result = (char *)allocate(val.size(), 1);
+  std::memcpy(result, val.data(), val.size());
+  return std::string_view(result, val.size());
+}
+
+std::size_t Arena::size() const noexcept { return used; }
+
+void Arena::clear() noexcept {
+  while (head != nullptr) {
+    auto previous = head->previous;
+    std::free(head);
+    head = previous;
+  }
+  cursor = nullptr;
+  limit = nullptr;
+  used = 0;
+}
+
+Arena::~Arena() noexcept { clear(); }
+
+} // namespace nuo
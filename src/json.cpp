@@ -1,5 +1,7 @@
 #include "nuo/json.hpp"
+#include "nuo/json_binding.hpp"
 #include "nuo/json_parser.hpp"
+#include "nuo/mapped_file.hpp"
 #include <cstdint>
 #include <initializer_list>
 #include <iostream>
@@ -7,286 +9,222 @@
 
 namespace nuo {
 
-JsonValue::JsonValue(JsonValueType type, void *data)
-    : data(data), type(type) {}
+static_assert(sizeof(JsonValue) == 16, "JsonValue should fit in 16 bytes");
 
-JsonValue JsonValue::none() { return {JsonValueType::none, nullptr}; }
+JsonValue::JsonValue(JsonValueType type) : storage(), type(type) {}
 
-JsonValue::operator bool() const { return (type != JsonValueType::none); }
+JsonValue JsonValue::none() { return JsonValue(JsonValueType::none); }
 
-JsonValue::JsonValue() : data(nullptr), type(JsonValueType::null) {}
+JsonValue::operator bool() const { return (type != JsonValueType::none); }
 
-JsonValue::JsonValue(const int val)
-    : data(new int64_t(val)), type(JsonValueType::integer) {}
+JsonValue::JsonValue() : storage(), type(JsonValueType::null) {}
 
-void JsonValue::operator=(const int val) {
-  if (isInt()) {
-    *((int64_t *)data) = (int64_t)val;
+void JsonValue::storeString(std::string_view val) {
+  type = JsonValueType::string;
+  if (val.size() <= maxInline) {
+    std::memcpy(storage, val.data(), val.size());
+    storage[maxInline] = (unsigned char)val.size();
   } else {
-    clear();
-    type = JsonValueType::integer;
-    data = new int64_t(val);
+    allocate<std::string>(val);
+    storage[maxInline] = heapString;
+  }
+}
+
+std::string_view JsonValue::view() const {
+  if (storage[maxInline] == heapString) {
+    return *heap<std::string>();
   }
+  return std::string_view((const char *)storage, storage[maxInline]);
+}
+
+JsonValue::JsonValue(const int val) : storage(), type(JsonValueType::integer) {
+  store<int64_t>(val);
+}
+
+void JsonValue::operator=(const int val) {
+  clear();
+  type = JsonValueType::integer;
+  store<int64_t>(val);
 }
 
 JsonValue::JsonValue(const unsigned val)
-    : data(new int64_t((int64_t)val)), type(JsonValueType::integer) {}
+    : storage(), type(JsonValueType::integer) {
+  store<int64_t>((int64_t)val);
+}
 
 void JsonValue::operator=(const unsigned val) {
-  if (isInt()) {
-    *((int64_t *)data) = (int64_t)val;
-  } else {
-    clear();
-    type = JsonValueType::integer;
-    data = new int64_t((int64_t)val);
-  }
+  clear();
+  type = JsonValueType::integer;
+  store<int64_t>((int64_t)val);
 }
 
 JsonValue::JsonValue(const unsigned long long val)
-    : data(new int64_t((int64_t)val)), type(JsonValueType::integer) {}
+    : storage(), type(JsonValueType::integer) {
+  store<int64_t>((int64_t)val);
+}
 
 void JsonValue::operator=(const unsigned long long val) {
-  if (isInt()) {
-    *((int64_t *)data) = (int64_t)val;
-  } else {
-    clear();
-    type = JsonValueType::integer;
-    data = new int64_t((int64_t)val);
-  }
+  clear();
+  type = JsonValueType::integer;
+  store<int64_t>((int64_t)val);
 }
 
 #if PLATFORM_IS_UNIX
 JsonValue::JsonValue(const uint64_t val)
-    : data(new int64_t((int64_t)val)), type(JsonValueType::integer) {}
+    : storage(), type(JsonValueType::integer) {
+  store<int64_t>((int64_t)val);
+}
 
 void JsonValue::operator=(const uint64_t val) {
-  if (isInt()) {
-    *((int64_t *)data) = (int64_t)val;
-  } else {
-    clear();
-    type = JsonValueType::integer;
-    data = new int64_t((int64_t)val);
-  }
+  clear();
+  type = JsonValueType::integer;
+  store<int64_t>((int64_t)val);
 }
 #endif
 
 JsonValue::JsonValue(const int64_t val)
-    : data(new int64_t(val)), type(JsonValueType::integer) {}
+    : storage(), type(JsonValueType::integer) {
+  store<int64_t>(val);
+}
 
 void JsonValue::operator=(const int64_t val) {
-  if (isInt()) {
-    *((int64_t *)data) = val;
-  } else {
-    clear();
-    type = JsonValueType::integer;
-    data = new int64_t(val);
-  }
+  clear();
+  type = JsonValueType::integer;
+  store<int64_t>(val);
 }
 
 JsonValue::JsonValue(const double val)
-    : data(new double(val)), type(JsonValueType::decimal) {}
+    : storage(), type(JsonValueType::decimal) {
+  store<double>(val);
+}
 
 void JsonValue::operator=(const double val) {
-  if (isDouble()) {
-    *((double *)data) = val;
-  } else {
-    clear();
-    type = JsonValueType::decimal;
-    data = new double(val);
-  }
+  clear();
+  type = JsonValueType::decimal;
+  store<double>(val);
 }
 
 JsonValue::JsonValue(const std::string val)
-    : data(new std::string(val)), type(JsonValueType::string) {}
+    : storage(), type(JsonValueType::string) {
+  storeString(val);
+}
 
 void JsonValue::operator=(const std::string val) {
-  if (isString()) {
-    *((std::string *)data) = val;
+  if (isString() && (storage[maxInline] == heapString) &&
+      (val.size() > maxInline)) {
+    *unique<std::string>() = val;
   } else {
     clear();
-    type = JsonValueType::string;
-    data = new std::string(val);
+    storeString(val);
   }
 }
 
+JsonValue::JsonValue(std::string_view val)
+    : storage(), type(JsonValueType::string) {
+  storeString(val);
+}
+
 JsonValue::JsonValue(const char *val)
-    : data(new std::string(val)), type(JsonValueType::string) {}
+    : storage(), type(JsonValueType::string) {
+  storeString(val);
+}
 
 void JsonValue::operator=(const char *val) {
-  if (isString()) {
-    *((std::string *)data) = std::string(val);
-  } else {
-    clear();
-    type = JsonValueType::string;
-    data = new std::string(val);
-  }
+  clear();
+  storeString(val);
 }
 
 JsonValue::JsonValue(const bool val)
-    : data(new bool(val)), type(JsonValueType::boolean) {}
+    : storage(), type(JsonValueType::boolean) {
+  store<bool>(val);
+}
 
 void JsonValue::operator=(const bool val) {
-  if (isBool()) {
-    *((bool *)data) = val;
-  } else {
-    clear();
-    type = JsonValueType::boolean;
-    data = new bool(val);
-  }
+  clear();
+  type = JsonValueType::boolean;
+  store<bool>(val);
 }
 
-JsonValue::JsonValue(Json const &val)
-    : data(new Json(val)), type(JsonValueType::json) {}
+JsonValue::JsonValue(Json const &val) : storage(), type(JsonValueType::json) {
+  allocate<Json>(val);
+}
 
 void JsonValue::operator=(Json const &val) {
-  if (isJson()) {
-    *((Json *)data) = val;
-  } else {
-    clear();
-    type = JsonValueType::json;
-    data = new Json(val);
-  }
+  auto copy = JsonValue(val);
+  *this = std::move(copy);
 }
 
-JsonValue::JsonValue(Json &&val) : data(new Json()), type(JsonValueType::json) {
-  *((Json *)data) = std::move(val);
+JsonValue::JsonValue(Json &&val) : storage(), type(JsonValueType::json) {
+  allocate<Json>(std::move(val));
+}
+
+void JsonValue::operator=(Json &&val) {
+  auto moved = JsonValue(std::move(val));
+  *this = std::move(moved);
 }
 
 JsonValue::JsonValue(std::vector<JsonValue> const &val)
-    : data(new std::vector<JsonValue>()), type(JsonValueType::list) {
-  *((std::vector<JsonValue> *)data) = val;
+    : storage(), type(JsonValueType::list) {
+  allocate<std::vector<JsonValue>>(val);
 }
 
 void JsonValue::operator=(std::vector<JsonValue> const &val) {
-  if (isList()) {
-    ((std::vector<JsonValue> *)data)->clear();
-    *((std::vector<JsonValue> *) data) = val;
-  } else {
-    clear();
-    type = JsonValueType::list;
-    data = new std::vector<JsonValue>(val);
-  }
+  auto copy = JsonValue(val);
+  *this = std::move(copy);
 }
 
 JsonValue::JsonValue(std::vector<JsonValue> &&val)
-    : data(new std::vector<JsonValue>()), type(JsonValueType::list) {
-  *((std::vector<JsonValue> *)data) = std::move(val);
+    : storage(), type(JsonValueType::list) {
+  allocate<std::vector<JsonValue>>(std::move(val));
 }
 
 void JsonValue::operator=(std::vector<JsonValue> &&val) {
-  if (isList()) {
-    ((std::vector<JsonValue> *)data)->clear();
-    *((std::vector<JsonValue> *)data) = std::move(val);
-  } else {
-    clear();
-    type = JsonValueType::list;
-    data = new std::vector<JsonValue>(std::move(val));
-  }
+  auto moved = JsonValue(std::move(val));
+  *this = std::move(moved);
 }
 
 JsonValue::JsonValue(const std::initializer_list<JsonValue> val)
-    : data(new std::vector<JsonValue>()), type(JsonValueType::list) {
-  for (auto const &elem : val) {
-    ((std::vector<JsonValue> *)data)->push_back(elem);
-  }
+    : storage(), type(JsonValueType::list) {
+  allocate<std::vector<JsonValue>>(val);
 }
 
 void JsonValue::operator=(const std::initializer_list<JsonValue> val) {
-  clear();
-  type = JsonValueType::list;
-  data = new std::vector<JsonValue>();
-  for (auto const &elem : val) {
-    ((std::vector<JsonValue> *)data)->push_back(elem);
-  }
+  auto list = JsonValue(val);
+  *this = std::move(list);
 }
 
-JsonValue::JsonValue(JsonValue &&other) noexcept {
-  type = other.type;
-  data = other.data;
-  other.data = nullptr;
+JsonValue::JsonValue(JsonValue &&other) noexcept : type(other.type) {
+  std::memcpy(storage, other.storage, sizeof(storage));
   other.type = JsonValueType::none;
 }
 
 JsonValue &JsonValue::operator=(JsonValue &&other) noexcept {
-  clear();
-  type = other.type;
-  data = other.data;
-  other.data = nullptr;
-  other.type = JsonValueType::none;
+  if (this != &other) {
+    clear();
+    type = other.type;
+    std::memcpy(storage, other.storage, sizeof(storage));
+    other.type = JsonValueType::none;
+  }
   return *this;
 }
 
-JsonValue::JsonValue(JsonValue const &other)
-    : data(nullptr), type(JsonValueType::none) {
-  switch (other.type) {
-  case JsonValueType::integer: {
-    data = new int64_t(*((int64_t *)other.data));
-    break;
-  }
-  case JsonValueType::decimal: {
-    data = new double(*((double *)other.data));
-    break;
-  }
-  case JsonValueType::string: {
-    data = new std::string(*((std::string *)other.data));
-    break;
-  }
-  case JsonValueType::boolean: {
-    data = new bool(*((bool *)other.data));
-    break;
-  }
-  case JsonValueType::json: {
-    data = new Json(*((Json *)other.data));
-    break;
+JsonValue::JsonValue(JsonValue const &other) : type(other.type) {
+  std::memcpy(storage, other.storage, sizeof(storage));
+  bool shared = (type == JsonValueType::json) ||
+                (type == JsonValueType::list) ||
+                ((type == JsonValueType::string) &&
+                 (storage[maxInline] == heapString));
+  if (shared) {
+    load<Counted *>()->references.fetch_add(1, std::memory_order_relaxed);
   }
-  case JsonValueType::list: {
-    data = new std::vector<JsonValue>();
-    *(std::vector<JsonValue> *)data = *((std::vector<JsonValue> *)other.data);
-    break;
-  }
-  case JsonValueType::null:
-  case JsonValueType::none: {
-    break;
-  }
-  }
-  type = other.type;
 }
 
 JsonValue &JsonValue::operator=(JsonValue const &other) {
-  clear();
-  type = other.type;
-  switch (type) {
-  case JsonValueType::integer: {
-    data = new int64_t(*((int64_t *)other.data));
-    break;
-  }
-  case JsonValueType::decimal: {
-    data = new double(*((double *)other.data));
-    break;
-  }
-  case JsonValueType::string: {
-    data = new std::string(*((std::string *)other.data));
-    break;
-  }
-  case JsonValueType::boolean: {
-    data = new bool(*((bool *)other.data));
-    break;
-  }
-  case JsonValueType::json: {
-    data = new Json(*((Json *)other.data));
-    break;
-  }
-  case JsonValueType::list: {
-    data = new std::vector<JsonValue>();
-    *(std::vector<JsonValue> *)data = *((std::vector<JsonValue> *)other.data);
-    break;
+  if (this == &other) {
+    return *this;
   }
-  case JsonValueType::null:
-  case JsonValueType::none: {
-    break;
-  }
-  }
-  return *this;
+  auto copy = JsonValue(other);
+  return *this = std::move(copy);
 }
 
 bool JsonValue::operator==(JsonValue const &other) const {
@@ -295,30 +233,23 @@ bool JsonValue::operator==(JsonValue const &other) const {
   }
   switch (type) {
   case JsonValueType::integer: {
-    return (*((int64_t *)data)) == (*((int64_t *)other.data));
+    return load<int64_t>() == other.load<int64_t>();
   }
   case JsonValueType::decimal: {
-    return (*((double *)data)) == (*((double *)other.data));
+    return load<double>() == other.load<double>();
   }
   case JsonValueType::string: {
-    return (*((std::string *)data)) == (*((std::string *)other.data));
+    return view() == other.view();
   }
   case JsonValueType::boolean: {
-    return (*((bool *)data)) == (*((bool *)other.data));
+    return load<bool>() == other.load<bool>();
   }
   case JsonValueType::json: {
-    return (*((Json *)data)) == (*((Json *)other.data));
+    return (*heap<Json>()) == (*other.heap<Json>());
   }
   case JsonValueType::list: {
-    if (((std::vector<JsonValue> *)other.data)->size() != ((std::vector<JsonValue> *)data)->size()) {
-      return false;
-    }
-      for (std::size_t i = 0; i < ((std::vector<JsonValue> *)data)->size(); i++) {
-          if (((std::vector<JsonValue> *)data)->at(i) != ((std::vector<JsonValue> *)other.data)->at(i)) {
-              return false;
-          }
-      }
-      return true;
+    return (*heap<std::vector<JsonValue>>()) ==
+           (*other.heap<std::vector<JsonValue>>());
   }
   case JsonValueType::null:
   case JsonValueType::none: {
@@ -333,39 +264,39 @@ bool JsonValue::operator!=(const JsonValue &other) const {
 
 bool JsonValue::operator==(const int val) const {
   if (isInt()) {
-    return ((*((int64_t *)data)) == ((int64_t)val));
+    return (load<int64_t>() == ((int64_t)val));
   }
   return false;
 }
 bool JsonValue::operator!=(const int val) const {
   if (isInt()) {
-    return ((*((int64_t *)data)) != ((int64_t)val));
+    return (load<int64_t>() != ((int64_t)val));
   }
   return true;
 }
 
 bool JsonValue::operator==(const unsigned val) const {
   if (isInt()) {
-    return ((*((int64_t *)data)) == ((int64_t)val));
+    return (load<int64_t>() == ((int64_t)val));
   }
   return false;
 }
 bool JsonValue::operator!=(const unsigned val) const {
   if (isInt()) {
-    return ((*((int64_t *)data)) != ((int64_t)val));
+    return (load<int64_t>() != ((int64_t)val));
   }
   return true;
 }
 
 bool JsonValue::operator==(const unsigned long long val) const {
   if (isInt()) {
-    return ((*((int64_t *)data)) == ((int64_t)val));
+    return (load<int64_t>() == ((int64_t)val));
   }
   return false;
 }
 bool JsonValue::operator!=(const unsigned long long val) const {
   if (isInt()) {
-    return ((*((int64_t *)data)) != ((int64_t)val));
+    return (load<int64_t>() != ((int64_t)val));
   }
   return true;
 }
@@ -373,13 +304,13 @@ bool JsonValue::operator!=(const unsigned long long val) const {
 #if PLATFORM_IS_UNIX
 bool JsonValue::operator==(const uint64_t val) const {
   if (isInt()) {
-    return ((*((int64_t *)data)) == ((int64_t)val));
+    return (load<int64_t>() == ((int64_t)val));
   }
   return false;
 }
 bool JsonValue::operator!=(const uint64_t val) const {
   if (isInt()) {
-    return ((*((int64_t *)data)) != ((int64_t)val));
+    return (load<int64_t>() != ((int64_t)val));
   }
   return true;
 }
@@ -387,98 +318,98 @@ bool JsonValue::operator!=(const uint64_t val) const {
 
 bool JsonValue::operator==(const int64_t val) const {
   if (isInt()) {
-    return ((*((int64_t *)data)) == val);
+    return (load<int64_t>() == val);
   }
   return false;
 }
 bool JsonValue::operator!=(const int64_t val) const {
   if (isInt()) {
-    return ((*((int64_t *)data)) != val);
+    return (load<int64_t>() != val);
   }
   return true;
 }
 
 bool JsonValue::operator==(const float val) const {
   if (isDouble()) {
-    return ((*((double *)data)) == ((double)val));
+    return (load<double>() == ((double)val));
   }
   return false;
 }
 bool JsonValue::operator!=(const float val) const {
   if (isDouble()) {
-    return ((*((double *)data)) != ((double)val));
+    return (load<double>() != ((double)val));
   }
   return true;
 }
 
 bool JsonValue::operator==(const double val) const {
   if (isDouble()) {
-    return ((*((double *)data)) == val);
+    return (load<double>() == val);
   }
   return false;
 }
 bool JsonValue::operator!=(const double val) const {
   if (isDouble()) {
-    return ((*((double *)data)) != val);
+    return (load<double>() != val);
   }
   return true;
 }
 
 bool JsonValue::operator==(const char *val) const {
   if (isString()) {
-    return ((*((std::string *)data)) == std::string(val));
+    return (view() == std::string(val));
   }
   return false;
 }
 bool JsonValue::operator!=(const char *val) const {
   if (isString()) {
-    return ((*((std::string *)data)) != std::string(val));
+    return (view() != std::string(val));
   }
   return true;
 }
 
 bool JsonValue::operator==(const std::string val) const {
   if (isString()) {
-    return ((*((std::string *)data)) == val);
+    return (view() == val);
   }
   return false;
 }
 bool JsonValue::operator!=(const std::string val) const {
   if (isString()) {
-    return ((*((std::string *)data)) != val);
+    return (view() != val);
   }
   return true;
 }
 
 bool JsonValue::operator==(const bool val) const {
   if (isBool()) {
-    return ((*((bool *)data)) == val);
+    return (load<bool>() == val);
   }
   return false;
 }
 bool JsonValue::operator!=(const bool val) const {
   if (isBool()) {
-    return ((*((bool *)data)) != val);
+    return (load<bool>() != val);
   }
   return true;
 }
 
 bool JsonValue::operator==(const Json &val) const {
   if (isJson()) {
-    return ((*((Json *)data)) == val);
+    return ((*heap<Json>()) == val);
   }
   return false;
 }
 bool JsonValue::operator!=(const Json &val) const {
   if (isJson()) {
-    return ((*((Json *)data)) != val);
+    return ((*heap<Json>()) != val);
   }
   return true;
 }
 
 bool JsonValue::operator==(const std::vector<JsonValue> &val) const {
   if (isList()) {
-    auto thisList = (std::vector<JsonValue> *)data;
+    auto thisList = heap<std::vector<JsonValue>>();
     if (thisList->size() == val.size()) {
       for (std::size_t i = 0; i < val.size(); i++) {
         if (thisList->at(i) != val.at(i)) {
@@ -494,7 +425,7 @@ bool JsonValue::operator==(const std::vector<JsonValue> &val) const {
 }
 bool JsonValue::operator!=(const std::vector<JsonValue> &val) const {
   if (isList()) {
-    auto thisList = (std::vector<JsonValue> *)data;
+    auto thisList = heap<std::vector<JsonValue>>();
     if (thisList->size() == val.size()) {
       for (std::size_t i = 0; i < val.size(); i++) {
         if (thisList->at(i) != val.at(i)) {
@@ -511,7 +442,7 @@ bool JsonValue::operator!=(const std::vector<JsonValue> &val) const {
 
 bool JsonValue::operator==(const std::initializer_list<JsonValue> &val) const {
   if (isList()) {
-    auto thisList = (std::vector<JsonValue> *)data;
+    auto thisList = heap<std::vector<JsonValue>>();
     if (thisList->size() == val.size()) {
       std::size_t i = 0;
       for (const auto &elem : val) {
@@ -529,7 +460,7 @@ bool JsonValue::operator==(const std::initializer_list<JsonValue> &val) const {
 }
 bool JsonValue::operator!=(const std::initializer_list<JsonValue> &val) const {
   if (isList()) {
-    auto thisList = (std::vector<JsonValue> *)data;
+    auto thisList = heap<std::vector<JsonValue>>();
     if (thisList->size() == val.size()) {
       std::size_t i = 0;
       for (const auto &elem : val) {
@@ -549,46 +480,30 @@ bool JsonValue::operator!=(const std::initializer_list<JsonValue> &val) const {
 std::string JsonValue::toString(const bool isJson) const {
   switch (type) {
   case JsonValueType::string: {
-    auto thisStr = (std::string *)data;
+    auto thisStr = view();
     if (isJson) {
       std::string formatted;
-      for (auto ch : *thisStr) {
-        if (ch == '\n') {
-          formatted += "\\n";
-        } else if (ch == '\t') {
-          formatted += "\\t";
-        } else if (ch == '\b') {
-          formatted += "\\b";
-        } else if (ch == '\f') {
-          formatted += "\\f";
-        } else if (ch == '\\') {
-          formatted += "\\\\";
-        } else if (ch == '"') {
-          formatted += "\\\"";
-        } else {
-          formatted += ch;
-        }
-      }
-      return '"' + formatted + '"';
+      JsonWriter::escape(formatted, thisStr);
+      return formatted;
     } else {
-      return *thisStr;
+      return std::string(thisStr);
     }
   }
   case JsonValueType::integer: {
-    return std::to_string(*((int64_t *)data));
+    return std::to_string(load<int64_t>());
   }
   case JsonValueType::decimal: {
-    return std::to_string(*((double *)data));
+    return std::to_string(load<double>());
   }
   case JsonValueType::boolean: {
-    return (*((bool *)data)) ? "true" : "false";
+    return load<bool>() ? "true" : "false";
   }
   case JsonValueType::json: {
-    return ((Json *)data)->toString();
+    return heap<Json>()->toString();
   }
   case JsonValueType::list: {
     std::string result("[");
-    auto list = (std::vector<JsonValue> *)data;
+    auto list = heap<std::vector<JsonValue>>();
     for (std::size_t i = 0; i < list->size(); i++) {
       result += list->at(i).toString(isJson);
       if (i != (list->size() - 1)) {
@@ -612,24 +527,30 @@ JsonValueType JsonValue::getType() const { return type; }
 
 bool JsonValue::isBool() const { return (type == JsonValueType::boolean); }
 
-bool JsonValue::asBool() const { return *((bool *)data); }
+bool JsonValue::asBool() const { return load<bool>(); }
 
 bool JsonValue::isDouble() const { return (type == JsonValueType::decimal); }
 
-double JsonValue::asDouble() const { return *((double *)data); }
+double JsonValue::asDouble() const { return load<double>(); }
 
 bool JsonValue::isInt() const { return (type == JsonValueType::integer); }
 
-int64_t JsonValue::asInt() const { return *((int64_t *)data); }
+int64_t JsonValue::asInt() const { return load<int64_t>(); }
 
 bool JsonValue::isJson() const { return (type == JsonValueType::json); }
 
-nuo::Json JsonValue::asJson() const { return *((Json *)data); }
+nuo::Json JsonValue::asJson() const { return *heap<Json>(); }
+
+const nuo::Json &JsonValue::viewJson() const { return *heap<Json>(); }
 
 bool JsonValue::isList() const { return (type == JsonValueType::list); }
 
 std::vector<JsonValue> JsonValue::asList() const {
-  return *((std::vector<JsonValue> *)data);
+  return *(heap<std::vector<JsonValue>>());
+}
+
+std::span<const JsonValue> JsonValue::viewList() const {
+  return *heap<std::vector<JsonValue>>();
 }
 
 bool JsonValue::isNull() const { return (type == JsonValueType::null); }
@@ -638,7 +559,9 @@ bool JsonValue::isNone() const { return (type == JsonValueType::none); }
 
 bool JsonValue::isString() const { return (type == JsonValueType::string); }
 
-std::string JsonValue::asString() const { return *((std::string *)data); }
+std::string JsonValue::asString() const { return std::string(view()); }
+
+std::string_view JsonValue::viewString() const { return view(); }
 
 std::ostream &operator<<(std::ostream &stream, const JsonValue &val) {
   std::operator<<(stream, val.toString(true));
@@ -646,38 +569,26 @@ std::ostream &operator<<(std::ostream &stream, const JsonValue &val) {
 }
 
 void JsonValue::clear() {
-  if (data != nullptr) {
-    switch (type) {
-    case JsonValueType::string: {
-      delete (std::string *)data;
-      break;
-    }
-    case JsonValueType::integer: {
-      delete (int64_t *)data;
-      break;
-    }
-    case JsonValueType::decimal: {
-      delete (double *)data;
-      break;
-    }
-    case JsonValueType::boolean: {
-      delete (bool *)data;
-      break;
-    }
-    case JsonValueType::json: {
-      delete (Json *)data;
-      break;
-    }
-    case JsonValueType::list: {
-      delete (std::vector<JsonValue> *)data;
-      break;
-    }
-    case JsonValueType::null:
-    case JsonValueType::none:
-      break;
+  switch (type) {
+  case JsonValueType::string: {
+    if (storage[maxInline] == heapString) {
+      release<std::string>();
     }
-    data = nullptr;
+    break;
+  }
+  case JsonValueType::json: {
+    release<Json>();
+    break;
   }
+  case JsonValueType::list: {
+    release<std::vector<JsonValue>>();
+    break;
+  }
+  default: {
+    break;
+  }
+  }
+  type = JsonValueType::null;
 }
 
 JsonValue::~JsonValue() noexcept { clear(); }
@@ -685,37 +596,65 @@ JsonValue::~JsonValue() noexcept { clear(); }
 Json::Json() {}
 
 Json::Json(std::string val) : keys(), values() {
-  auto parser = JsonParser();
-  parser.lex(val);
-  auto res = parser.parse();
+  auto res = JsonParser::parse(val);
   keys = std::move(res.keys);
   values = std::move(res.values);
+  index = std::move(res.index);
   res.clear();
-  setLevel(res.level);
-  setSpaces(res.spaces);
+  level = res.level;
+  spaces = res.spaces;
+  spacesSet = res.spacesSet;
+}
+
+Json Json::fromFile(const std::string &path) {
+  auto file = MappedFile(path);
+  return JsonParser::parse(file.view());
+}
+
+Vague<Json> Json::tryParse(std::string_view text) {
+  auto error = JsonError();
+  return tryParse(text, error);
+}
+
+Vague<Json> Json::tryParse(std::string_view text, JsonError &error) {
+  return tryParse(text, JsonLimits(), error);
+}
+
+Vague<Json> Json::tryParse(std::string_view text, const JsonLimits &limits,
+                           JsonError &error) {
+  auto result = Json();
+  if (!JsonParser::tryParse(text, result, error, limits)) {
+    return Problem(error.message + " (line " + std::to_string(error.line) +
+                   ", column " + std::to_string(error.column) + ")");
+  }
+  return Vague<Json>(std::move(result));
 }
 
 Json::Json(Json const &other) : keys(), values() {
   keys = other.keys;
   values = other.values;
+  index = other.index;
   level = other.level;
   spaces = other.spaces;
+  spacesSet = other.spacesSet;
 }
 
 Json::Json(Json &&other) noexcept : keys(), values() {
   keys = std::move(other.keys);
   values = std::move(other.values);
+  index = std::move(other.index);
   other.clear();
   level = other.level;
   spaces = other.spaces;
+  spacesSet = other.spacesSet;
 }
 
 Json &Json::_(std::string key, JsonValue val) {
-  if (has(key)) {
-    (*this)[key] = val;
+  auto found = position(key);
+  if (found < keys.size()) {
+    values[found] = std::move(val);
   } else {
-    keys.push_back(key);
-    values.push_back(val);
+    append(JsonKey(key), std::move(val));
   }
   return *this;
 }
@@ -724,8 +663,10 @@ Json &Json::operator=(Json const &other) {
   clear();
   keys = other.keys;
   values = other.values;
+  index = other.index;
   level = other.level;
   spaces = other.spaces;
+  spacesSet = other.spacesSet;
   return *this;
 }
 
@@ -733,31 +674,24 @@ Json &Json::operator=(Json &&other) noexcept {
   clear();
   keys = std::move(other.keys);
   values = std::move(other.values);
+  index = std::move(other.index);
   other.clear();
   level = other.level;
   spaces = other.spaces;
+  spacesSet = other.spacesSet;
   return *this;
 }
 
-void Json::setLevel(unsigned lev) const {
-  level = lev;
-  for (auto val : values) {
-    if (val.isJson()) {
-      ((Json *)val.data)->setLevel(lev + 1);
-    }
-  }
-}
+void Json::setLevel(unsigned lev) const { level = lev; }
 
 void Json::setSpaces(unsigned spc) const {
   spaces = spc;
-  for (auto val : values) {
-    if (val.isJson()) {
-      ((Json *)val.data)->setSpaces(spc);
-    }
-  }
+  spacesSet = true;
 }
 
-std::string Json::toString() const {
+std::string Json::toString() const { return toString(level, spaces); }
+
+std::string Json::toString(unsigned lev, unsigned spc) const {
   if (size() == 0) {
     return "{}";
   } else {
@@ -769,22 +703,30 @@ std::string Json::toString() const {
         }
         continue;
       }
-      for (std::size_t j = 0; j < (level + 1); j++) {
-        for (std::size_t k = 0; k < spaces; k++) {
+      for (std::size_t j = 0; j < (lev + 1); j++) {
+        for (std::size_t k = 0; k < spc; k++) {
           result += " ";
         }
       }
+      // Members are indented here instead of by setting their level and
+      // spaces, because they can be shared with other documents
+      std::string member;
       if (values.at(i).isJson()) {
-        ((Json *)(values.at(i).data))->setLevel(level + 1);
+        auto object = values.at(i).heap<Json>();
+        member = object->toString(lev + 1,
+                                  object->spacesSet ? object->spaces : spc);
+      } else {
+        member = values.at(i).toString(true);
       }
-      result += ('"' + keys.at(i) + '"' + " : " + values.at(i).toString(true));
+      JsonWriter::escape(result, keys.at(i).text());
+      result += " : " + member;
       if ((i != (keys.size() - 1)) && (values.at(i + 1))) {
         result += ",\n";
       }
     }
     result += "\n";
-    for (std::size_t j = 0; j < level; j++) {
-      for (std::size_t k = 0; k < spaces; k++) {
+    for (std::size_t j = 0; j < lev; j++) {
+      for (std::size_t k = 0; k < spc; k++) {
         result += " ";
       }
     }
@@ -793,25 +735,128 @@ std::string Json::toString() const {
   }
 }
 
-bool Json::has(const std::string key) const {
+std::size_t Json::indexSlots(std::size_t keys) {
+  if (keys <= smallObject) {
+    return 0;
+  }
+  std::size_t slots = 64;
+  while (slots < (keys * 4)) {
+    slots *= 2;
+  }
+  return slots;
+}
+
+void Json::reindex() {
+  index.clear();
+  auto slots = indexSlots(keys.size());
+  if (slots == 0) {
+    return;
+  }
+  index.resize(slots, 0);
+  auto mask = slots - 1;
   for (std::size_t i = 0; i < keys.size(); i++) {
-    if (keys.at(i) == key) {
-      return true;
+    auto at = keys[i].hash() & mask;
+    while (index[at] != 0) {
+      at = (at + 1) & mask;
     }
+    index[at] = (uint32_t)(i + 1);
   }
-  return false;
 }
 
-JsonValue &Json::operator[](const std::string key) {
-  for (std::size_t i = 0; i < keys.size(); i++) {
-    if (keys.at(i) == key) {
-      return values[i];
+template <typename Equal>
+std::size_t Json::probe(std::size_t hash, Equal equal) const {
+  auto mask = index.size() - 1;
+  for (auto at = hash & mask; index[at] != 0; at = (at + 1) & mask) {
+    auto pos = index[at] - 1;
+    if ((keys[pos].entry->hash == hash) && equal(pos)) {
+      return pos;
+    }
+  }
+  return keys.size();
+}
+
+std::size_t Json::position(std::string_view key) const {
+  if (index.empty()) {
+    for (std::size_t i = 0; i < keys.size(); i++) {
+      if (keys[i].entry->text == key) {
+        return i;
+      }
+    }
+    return keys.size();
+  }
+  return probe(std::hash<std::string_view>()(key),
+               [&](std::size_t pos) { return keys[pos].entry->text == key; });
+}
+
+std::size_t Json::position(const JsonKey &key) const {
+  if (index.empty()) {
+    for (std::size_t i = 0; i < keys.size(); i++) {
+      if (keys[i] == key) {
+        return i;
+      }
+    }
+    return keys.size();
+  }
+  return probe(key.hash(), [&](std::size_t pos) { return keys[pos] == key; });
+}
+
+JsonValue &Json::append(JsonKey key, JsonValue value) {
+  keys.push_back(std::move(key));
+  values.push_back(std::move(value));
+  // Growing the index when it is half full keeps the probes short, and
+  // rebuilding it then costs a constant time for each key on average
+  if (keys.size() > (index.size() / 2)) {
+    reindex();
+  } else {
+    auto mask = index.size() - 1;
+    auto at = keys.back().hash() & mask;
+    while (index[at] != 0) {
+      at = (at + 1) & mask;
     }
+    index[at] = (uint32_t)keys.size();
   }
-  keys.push_back(key);
-  auto none = JsonValue::none();
-  values.push_back(none);
-  return values[values.size() - 1];
+  return values.back();
+}
+
+void Json::insert(std::size_t pos, JsonKey key, JsonValue value) {
+  keys.insert(keys.begin() + pos, std::move(key));
+  values.insert(values.begin() + pos, std::move(value));
+  reindex();
+}
+
+void Json::remove(std::size_t pos) {
+  keys.erase(keys.begin() + pos);
+  values.erase(values.begin() + pos);
+  reindex();
+}
+
+JsonValue &Json::slot(const JsonKey &key) {
+  auto found = position(key);
+  if (found < keys.size()) {
+    return values[found];
+  }
+  return append(key, JsonValue::none());
+}
+
+bool Json::has(const std::string key) const {
+  return position(key) < keys.size();
+}
+
+JsonValue &Json::operator[](const std::string key) {
+  auto found = position(key);
+  if (found < keys.size()) {
+    return values[found];
+  }
+  return append(JsonKey(key), JsonValue::none());
+}
+
+bool Json::erase(const std::string &key) {
+  auto found = position(key);
+  if (found == keys.size()) {
+    return false;
+  }
+  remove(found);
+  return true;
 }
 
 bool Json::operator==(const Json &other) const {
@@ -851,6 +896,7 @@ std::ostream &operator<<(std::ostream &os, const Json &json) {
 void Json::clear() noexcept {
   keys.clear();
   values.clear();
+  index.clear();
 }
 
 Json::~Json() noexcept { clear(); }
@@ -0,0 +1,381 @@
+#include "nuo/json_binding.hpp"
+#include <charconv>
+#include <cmath>
+
+namespace nuo {
+
+JsonCursor::JsonCursor(std::string_view _text)
+    : text(_text), index(_text), tok(JsonParser::TokenType::null),
+      keyTok(JsonParser::TokenType::null), peeked(false), first(),
+      consumed(0) {}
+
+JsonParser::TokenType JsonCursor::peek() {
+  if (!peeked) {
+    if (!JsonParser::lexNext(index, tok)) {
+      if (index.error.has()) {
+        throw Exception(index.error.message);
+      }
+      tok.type = JsonParser::TokenType::null;
+      tok.offset = text.size();
+      tok.length = 0;
+    }
+    peeked = true;
+  }
+  return tok.type;
+}
+
+bool JsonCursor::atEnd() {
+  peek();
+  return tok.offset == text.size();
+}
+
+JsonParser::Token &JsonCursor::take() {
+  if (atEnd()) {
+    throw Exception("Expected a value at the end of the text");
+  }
+  peeked = false;
+  consumed = tok.offset + tok.length;
+  return tok;
+}
+
+void JsonCursor::fail(const char *expected) const {
+  if (tok.offset == text.size()) {
+    throw Exception(std::string("Expected ") + expected +
+                    " at the end of the text");
+  }
+  throw Exception(std::string("Expected ") + expected + " at " +
+                  std::to_string(tok.offset));
+}
+
+bool JsonCursor::readBool() {
+  auto type = peek();
+  if ((type != JsonParser::TokenType::True) &&
+      (type != JsonParser::TokenType::False)) {
+    fail("a boolean");
+  }
+  return take().type == JsonParser::TokenType::True;
+}
+
+int64_t JsonCursor::readInt() {
+  if (peek() != JsonParser::TokenType::integer) {
+    fail("an integer");
+  }
+  return take().integer;
+}
+
+double JsonCursor::readDouble() {
+  auto type = peek();
+  if (type == JsonParser::TokenType::integer) {
+    return (double)take().integer;
+  } else if (type != JsonParser::TokenType::floating) {
+    fail("a number");
+  }
+  return take().decimal;
+}
+
+void JsonCursor::readString(std::string &result) {
+  if (peek() != JsonParser::TokenType::string) {
+    fail("a string");
+  }
+  result = take().view;
+}
+
+bool JsonCursor::readNull() {
+  if ((peek() == JsonParser::TokenType::null) && !atEnd()) {
+    take();
+    return true;
+  }
+  return false;
+}
+
+void JsonCursor::beginObject() {
+  if (peek() != JsonParser::TokenType::curlyBraceOpen) {
+    fail("an object");
+  }
+  take();
+  first.push_back(true);
+}
+
+bool JsonCursor::nextKey(std::string_view &key) {
+  if (atEnd()) {
+    fail("a key or }");
+  }
+  if (peek() == JsonParser::TokenType::curlyBraceClose) {
+    take();
+    first.pop_back();
+    return false;
+  }
+  if (!first.back()) {
+    if (peek() != JsonParser::TokenType::comma) {
+      fail(", or }");
+    }
+    take();
+  }
+  first.back() = false;
+  if (peek() != JsonParser::TokenType::string) {
+    fail("a key");
+  }
+  // The key is kept in its own token, since the colon is lexed next. A key
+  // with escape sequences is viewed in the decoded value, which moves
+  std::swap(tok, keyTok);
+  if ((keyTok.view.data() < text.data()) ||
+      (keyTok.view.data() > text.data() + text.size())) {
+    keyTok.view = keyTok.value;
+  }
+  peeked = false;
+  if (peek() != JsonParser::TokenType::colon) {
+    fail("a colon after the key");
+  }
+  take();
+  key = keyTok.view;
+  return true;
+}
+
+void JsonCursor::beginList() {
+  if (peek() != JsonParser::TokenType::bracketOpen) {
+    fail("a list");
+  }
+  take();
+  first.push_back(true);
+}
+
+bool JsonCursor::nextElement() {
+  if (atEnd()) {
+    fail("a value or ]");
+  }
+  if (peek() == JsonParser::TokenType::bracketClose) {
+    take();
+    first.pop_back();
+    return false;
+  }
+  if (!first.back()) {
+    if (peek() != JsonParser::TokenType::comma) {
+      fail(", or ]");
+    }
+    take();
+  }
+  first.back() = false;
+  return true;
+}
+
+void JsonCursor::skip() {
+  // Values inside are read with the same checks as the values that are bound,
+  // so skipped text is only accepted if it is valid Json. The kinds of the
+  // containers opened here are kept, with true for lists
+  std::vector<bool> lists;
+  do {
+    switch (peek()) {
+    case JsonParser::TokenType::curlyBraceOpen: {
+      beginObject();
+      lists.push_back(false);
+      break;
+    }
+    case JsonParser::TokenType::bracketOpen: {
+      beginList();
+      lists.push_back(true);
+      break;
+    }
+    case JsonParser::TokenType::curlyBraceClose:
+    case JsonParser::TokenType::bracketClose:
+    case JsonParser::TokenType::comma:
+    case JsonParser::TokenType::colon: {
+      fail("a value");
+    }
+    default: {
+      take();
+      break;
+    }
+    }
+    // Move to the next value, leaving the containers that end
+    while (!lists.empty()) {
+      std::string_view key;
+      if (lists.back() ? nextElement() : nextKey(key)) {
+        break;
+      }
+      lists.pop_back();
+    }
+  } while (!lists.empty());
+}
+
+JsonValue JsonCursor::readValue() {
+  peek();
+  auto start = tok.offset;
+  skip();
+  return JsonParser::parseValue(text.substr(start, consumed - start));
+}
+
+JsonWriter::JsonWriter() : first(), afterKey(false), result() {}
+
+void JsonWriter::separate() {
+  if (afterKey) {
+    afterKey = false;
+  } else if (!first.empty()) {
+    if (!first.back()) {
+      result += ',';
+    }
+    first.back() = false;
+  }
+}
+
+void JsonWriter::startObject() {
+  separate();
+  result += '{';
+  first.push_back(true);
+}
+
+void JsonWriter::endObject() {
+  result += '}';
+  first.pop_back();
+}
+
+void JsonWriter::startList() {
+  separate();
+  result += '[';
+  first.push_back(true);
+}
+
+void JsonWriter::endList() {
+  result += ']';
+  first.pop_back();
+}
+
+void JsonWriter::key(std::string_view key) {
+  string(key);
+  result += ':';
+  afterKey = true;
+}
+
+void JsonWriter::string(std::string_view val) {
+  separate();
+  escape(result, val);
+}
+
+void JsonWriter::escape(std::string &result, std::string_view val) {
+  result += '"';
+  std::size_t start = 0;
+  for (std::size_t i = 0; i < val.size(); i++) {
+    auto chr = (unsigned char)val[i];
+    if ((chr >= 0x20) && (chr != '"') && (chr != '\\')) {
+      continue;
+    }
+    result.append(val.data() + start, i - start);
+    start = i + 1;
+    switch (chr) {
+    case '"': {
+      result += "\\\"";
+      break;
+    }
+    case '\\': {
+      result += "\\\\";
+      break;
+    }
+    case '\n': {
+      result += "\\n";
+      break;
+    }
+    case '\r': {
+      result += "\\r";
+      break;
+    }
+    case '\t': {
+      result += "\\t";
+      break;
+    }
+    case '\b': {
+      result += "\\b";
+      break;
+    }
+    case '\f': {
+      result += "\\f";
+      break;
+    }
+    default: {
+      const char *hex = "0123456789abcdef";
+      result += "\\u00";
+      result += hex[chr >> 4];
+      result += hex[chr & 0xF];
+      break;
+    }
+    }
+  }
+  result.append(val.data() + start, val.size() - start);
+  result += '"';
+}
+
+void JsonWriter::integer(int64_t val) {
+  separate();
+  char buffer[24];
+  auto end = std::to_chars(buffer, buffer + sizeof(buffer), val).ptr;
+  result.append(buffer, end - buffer);
+}
+
+void JsonWriter::decimal(double val) {
+  separate();
+  // Json has no representation for infinity and NaN
+  if (!std::isfinite(val)) {
+    result += "null";
+    return;
+  }
+  // The shortest text that reads back as the same double
+  char buffer[32];
+  auto end = std::to_chars(buffer, buffer + sizeof(buffer), val).ptr;
+  result.append(buffer, end - buffer);
+}
+
+void JsonWriter::boolean(bool val) {
+  separate();
+  result += val ? "true" : "false";
+}
+
+void JsonWriter::null() {
+  separate();
+  result += "null";
+}
+
+void JsonWriter::value(const JsonValue &val) {
+  switch (val.type) {
+  case JsonValueType::integer: {
+    integer(val.load<int64_t>());
+    break;
+  }
+  case JsonValueType::decimal: {
+    decimal(val.load<double>());
+    break;
+  }
+  case JsonValueType::string: {
+    string(val.view());
+    break;
+  }
+  case JsonValueType::boolean: {
+    boolean(val.load<bool>());
+    break;
+  }
+  case JsonValueType::null:
+  case JsonValueType::none: {
+    null();
+    break;
+  }
+  case JsonValueType::json: {
+    auto &object = *val.heap<Json>();
+    startObject();
+    for (std::size_t i = 0; i < object.keys.size(); i++) {
+      if (!object.values[i].isNone()) {
+        key(object.keys[i].text());
+        value(object.values[i]);
+      }
+    }
+    endObject();
+    break;
+  }
+  case JsonValueType::list: {
+    startList();
+    for (auto &elem : *val.heap<std::vector<JsonValue>>()) {
+      value(elem);
+    }
+    endList();
+    break;
+  }
+  }
+}
+
+} // namespace nuo
@@ -0,0 +1,418 @@
+#include "nuo/json_diff.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nuo {
+
+namespace {
+
+// Lists whose changed parts would need a larger table than this are patched
+// element by element instead of around their longest common subsequence
+const std::size_t maxTableCells = std::size_t(1) << 20;
+
+uint64_t mix(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+  return value ^ (value >> 31);
+}
+
+// Integers and decimals that are equal in value have the same hash
+uint64_t numberHash(double value) {
+  if (value == 0) {
+    value = 0;
+  }
+  return mix(std::bit_cast<uint64_t>(value) + 1);
+}
+
+// Integers that are exactly a double have the hash of that double, so that
+// they hash like the decimals they are equal to. Larger integers are hashed
+// by their exact value, since several of them round to the same double
+uint64_t integerHash(int64_t value) {
+  auto rounded = (double)value;
+  if ((rounded != 9223372036854775808.0) && ((int64_t)rounded == value)) {
+    return numberHash(rounded);
+  }
+  return mix(std::bit_cast<uint64_t>(value) ^ 0x510E527FADE682D1ULL);
+}
+
+using OperationType = JsonPatch::OperationType;
+
+} // namespace
+
+// Walks two documents at the same time. Hashes of objects and lists are kept
+// by their address, so that every value is hashed at most once
+class JsonDiff::Walker {
+private:
+  std::unordered_map<const void *, uint64_t> hashes;
+
+  // Unescaped tokens of the container that is being compared
+  std::vector<std::string> path;
+
+  JsonPointer pointer(std::string token) const {
+    auto tokens = path;
+    tokens.push_back(std::move(token));
+    return JsonPointer(std::move(tokens));
+  }
+
+  void emit(OperationType type, std::string token, JsonValue value) {
+    ops.emplace_back(type, pointer(std::move(token)), JsonPointer(""),
+                     std::move(value));
+  }
+
+  // The value of the key in the object, or null if it is not there. Objects
+  // that are compared often have their keys in the same order, so the
+  // position of the key in the other object is tried first
+  static const JsonValue *find(const Json &object, const JsonKey &key,
+                               std::size_t hint) {
+    if ((hint < object.keys.size()) && (object.keys[hint] == key)) {
+      return object.values[hint].isNone() ? nullptr : &object.values[hint];
+    }
+    auto found = object.position(key);
+    if (found == object.keys.size()) {
+      return nullptr;
+    }
+    return object.values[found].isNone() ? nullptr : &object.values[found];
+  }
+
+  static const std::vector<JsonValue> &list(const JsonValue &value) {
+    return *value.heap<std::vector<JsonValue>>();
+  }
+
+  static const Json &object(const JsonValue &value) {
+    return *value.heap<Json>();
+  }
+
+  static double number(const JsonValue &value) {
+    return value.isInt() ? (double)value.asInt() : value.asDouble();
+  }
+
+  uint64_t hash(const Json &value) {
+    auto found = hashes.find(&value);
+    if (found != hashes.end()) {
+      return found->second;
+    }
+    // The members are added, so that their order does not change the hash
+    uint64_t result = 0x6A09E667F3BCC908ULL;
+    for (std::size_t i = 0; i < value.keys.size(); i++) {
+      if (!value.values[i].isNone()) {
+        result += mix(value.keys[i].hash() ^
+                      (hash(value.values[i]) * 0x9E3779B97F4A7C15ULL));
+      }
+    }
+    hashes.emplace(&value, result);
+    return result;
+  }
+
+  uint64_t hash(const std::vector<JsonValue> &value) {
+    auto found = hashes.find(&value);
+    if (found != hashes.end()) {
+      return found->second;
+    }
+    uint64_t result = 0xBB67AE8584CAA73BULL;
+    for (auto &elem : value) {
+      result = mix(result + hash(elem));
+    }
+    hashes.emplace(&value, result);
+    return result;
+  }
+
+  uint64_t hash(const JsonValue &value) {
+    switch (value.type) {
+    case JsonValueType::integer: {
+      return integerHash(value.asInt());
+    }
+    case JsonValueType::decimal: {
+      return numberHash(value.asDouble());
+    }
+    case JsonValueType::string: {
+      return std::hash<std::string_view>()(value.view());
+    }
+    case JsonValueType::boolean: {
+      return value.asBool() ? 0x3C6EF372FE94F82BULL : 0xA54FF53A5F1D36F1ULL;
+    }
+    case JsonValueType::json: {
+      return hash(object(value));
+    }
+    case JsonValueType::list: {
+      return hash(list(value));
+    }
+    default: {
+      return 0x510E527FADE682D1ULL;
+    }
+    }
+  }
+
+  bool same(const std::vector<JsonValue> &first,
+            const std::vector<JsonValue> &second) {
+    if (&first == &second) {
+      return true;
+    }
+    if ((first.size() != second.size()) || (hash(first) != hash(second))) {
+      return false;
+    }
+    for (std::size_t i = 0; i < first.size(); i++) {
+      if (!same(first[i], second[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Append the operations for a run of `removed` values of the source list
+  // that are replaced by `inserted` values of the target list. The values are
+  // paired up and patched in place, and the rest are removed or added
+  void replaceRun(const std::vector<JsonValue> &source, std::size_t from,
+                  std::size_t removed, const std::vector<JsonValue> &target,
+                  std::size_t to, std::size_t inserted, std::size_t &position) {
+    auto paired = std::min(removed, inserted);
+    for (std::size_t i = 0; i < paired; i++, position++) {
+      diff(source[from + i], target[to + i], std::to_string(position));
+    }
+    for (std::size_t i = paired; i < removed; i++) {
+      emit(OperationType::remove, std::to_string(position),
+           JsonValue::none());
+    }
+    for (std::size_t i = paired; i < inserted; i++, position++) {
+      emit(OperationType::add, std::to_string(position),
+           JsonValue(target[to + i]));
+    }
+  }
+
+  void diff(const std::vector<JsonValue> &source,
+            const std::vector<JsonValue> &target) {
+    // Values that are the same at both ends are left alone
+    std::size_t start = 0;
+    while ((start < source.size()) && (start < target.size()) &&
+           same(source[start], target[start])) {
+      start++;
+    }
+    std::size_t end = 0;
+    while ((end < source.size() - start) && (end < target.size() - start) &&
+           same(source[source.size() - 1 - end],
+                target[target.size() - 1 - end])) {
+      end++;
+    }
+    auto rows = source.size() - start - end;
+    auto columns = target.size() - start - end;
+    auto position = start;
+    if ((rows + 1) * (columns + 1) > maxTableCells) {
+      return replaceRun(source, start, rows, target, start, columns,
+                        position);
+    }
+    std::vector<uint64_t> sourceHashes(rows);
+    std::vector<uint64_t> targetHashes(columns);
+    for (std::size_t i = 0; i < rows; i++) {
+      sourceHashes[i] = hash(source[start + i]);
+    }
+    for (std::size_t j = 0; j < columns; j++) {
+      targetHashes[j] = hash(target[start + j]);
+    }
+    // Length of the longest common subsequence of the values after i in the
+    // source and after j in the target
+    std::vector<uint32_t> table((rows + 1) * (columns + 1), 0);
+    auto common = [&](std::size_t i, std::size_t j) -> uint32_t & {
+      return table[(i * (columns + 1)) + j];
+    };
+    for (std::size_t i = rows; i-- > 0;) {
+      for (std::size_t j = columns; j-- > 0;) {
+        common(i, j) = (sourceHashes[i] == targetHashes[j])
+                           ? common(i + 1, j + 1) + 1
+                           : std::max(common(i + 1, j), common(i, j + 1));
+      }
+    }
+    std::size_t i = 0;
+    std::size_t j = 0;
+    std::size_t removed = 0;
+    std::size_t inserted = 0;
+    while ((i < rows) || (j < columns)) {
+      if ((i < rows) && (j < columns) &&
+          (sourceHashes[i] == targetHashes[j]) &&
+          same(source[start + i], target[start + j])) {
+        replaceRun(source, start + i - removed, removed, target,
+                   start + j - inserted, inserted, position);
+        removed = 0;
+        inserted = 0;
+        i++;
+        j++;
+        position++;
+      } else if ((j == columns) ||
+                 ((i < rows) && (common(i + 1, j) >= common(i, j + 1)))) {
+        removed++;
+        i++;
+      } else {
+        inserted++;
+        j++;
+      }
+    }
+    replaceRun(source, start + i - removed, removed, target,
+               start + j - inserted, inserted, position);
+  }
+
+  void diff(const JsonValue &source, const JsonValue &target,
+            std::string token) {
+    if (same(source, target)) {
+      return;
+    }
+    if ((source.type == target.type) &&
+        ((source.type == JsonValueType::json) ||
+         (source.type == JsonValueType::list))) {
+      path.push_back(std::move(token));
+      if (source.type == JsonValueType::json) {
+        diff(object(source), object(target));
+      } else {
+        diff(list(source), list(target));
+      }
+      path.pop_back();
+      return;
+    }
+    emit(OperationType::replace, std::move(token), JsonValue(target));
+  }
+
+public:
+  std::vector<JsonPatch::Operation> ops;
+
+  Walker() : hashes(), path(), ops() {}
+
+  // Equality as defined by JSON Patch. Objects and lists that are in the same
+  // place in memory are equal without being visited, and objects and lists
+  // with different hashes are different without being visited
+  bool same(const JsonValue &first, const JsonValue &second) {
+    // Two integers are compared exactly, since integers above 2^53 that
+    // differ can be the same double
+    bool mixed = (first.isInt() && second.isDouble()) ||
+                 (first.isDouble() && second.isInt());
+    if (mixed) {
+      return number(first) == number(second);
+    }
+    if (first.type != second.type) {
+      return false;
+    }
+    switch (first.type) {
+    case JsonValueType::json: {
+      return same(object(first), object(second));
+    }
+    case JsonValueType::list: {
+      return same(list(first), list(second));
+    }
+    default: {
+      return first == second;
+    }
+    }
+  }
+
+  bool same(const Json &first, const Json &second) {
+    if (&first == &second) {
+      return true;
+    }
+    if ((hash(first) != hash(second)) || (first.size() != second.size())) {
+      return false;
+    }
+    for (std::size_t i = 0; i < first.keys.size(); i++) {
+      if (first.values[i].isNone()) {
+        continue;
+      }
+      auto other = find(second, first.keys[i], i);
+      if ((other == nullptr) || !same(first.values[i], *other)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void diff(const Json &source, const Json &target) {
+    for (std::size_t i = 0; i < source.keys.size(); i++) {
+      if (!source.values[i].isNone() &&
+          (find(target, source.keys[i], i) == nullptr)) {
+        emit(OperationType::remove, source.keys[i].text(), JsonValue::none());
+      }
+    }
+    for (std::size_t i = 0; i < target.keys.size(); i++) {
+      if (target.values[i].isNone()) {
+        continue;
+      }
+      auto old = find(source, target.keys[i], i);
+      if (old == nullptr) {
+        emit(OperationType::add, target.keys[i].text(),
+             JsonValue(target.values[i]));
+      } else {
+        diff(*old, target.values[i], target.keys[i].text());
+      }
+    }
+  }
+
+  Json merge(const Json &source, const Json &target) {
+    Json result;
+    for (std::size_t i = 0; i < source.keys.size(); i++) {
+      if (!source.values[i].isNone() &&
+          (find(target, source.keys[i], i) == nullptr)) {
+        result.append(source.keys[i], JsonValue());
+      }
+    }
+    for (std::size_t i = 0; i < target.keys.size(); i++) {
+      auto &value = target.values[i];
+      auto old = find(source, target.keys[i], i);
+      if (value.isNone() || ((old != nullptr) && same(*old, value)) ||
+          ((old == nullptr) && value.isNull())) {
+        continue;
+      }
+      if ((old != nullptr) && old->isJson() && value.isJson()) {
+        auto changes = merge(object(*old), object(value));
+        if (changes.size() > 0) {
+          result.append(target.keys[i], JsonValue(std::move(changes)));
+        }
+        continue;
+      }
+      result.append(target.keys[i], JsonValue(value));
+    }
+    return result;
+  }
+};
+
+JsonPatch JsonDiff::patch(const Json &source, const Json &target) {
+  auto walker = Walker();
+  if (!walker.same(source, target)) {
+    walker.diff(source, target);
+  }
+  return JsonPatch(std::move(walker.ops));
+}
+
+Json JsonDiff::mergePatch(const Json &source, const Json &target) {
+  auto walker = Walker();
+  if (walker.same(source, target)) {
+    return Json();
+  }
+  return walker.merge(source, target);
+}
+
+void JsonDiff::applyMergePatch(Json &document, const Json &patch) {
+  for (std::size_t i = 0; i < patch.keys.size(); i++) {
+    auto &key = patch.keys[i];
+    auto &value = patch.values[i];
+    if (value.isNone()) {
+      continue;
+    }
+    if (value.isNull()) {
+      document.erase(key.text());
+      continue;
+    }
+    auto existing = &document.slot(key);
+    if (value.isJson()) {
+      // Objects in the patch are merged, so that their null members are not
+      // added to the document
+      if (!existing->isJson()) {
+        *existing = Json();
+      }
+      applyMergePatch(*existing->unique<Json>(), *value.heap<Json>());
+    } else {
+      *existing = JsonValue(value);
+    }
+  }
+}
+
+} // namespace nuo
@@ -0,0 +1,252 @@
+#include "nuo/json_document.hpp"
+#include "nuo/exception.hpp"
+#include "nuo/json_parser.hpp"
+
+namespace nuo {
+
+// Handler that appends the reported values to the nodes of a document
+class JsonDocument::Builder {
+private:
+  JsonDocument &doc;
+  std::string_view source;
+
+  // Indices of the open objects and lists
+  std::vector<uint32_t> open;
+
+  std::string_view pendingKey;
+
+  // Views into the source are kept as they are. Other views point to the
+  // parser's decoding buffer, so they are copied into the document
+  std::string_view keep(std::string_view val) {
+    if ((val.data() >= source.data()) &&
+        (val.data() + val.size() <= source.data() + source.size())) {
+      return val;
+    }
+    return doc.decoded.copy(val);
+  }
+
+  Node &add(JsonValueType type) {
+    if (open.empty() && !doc.nodes.empty()) {
+      throw Exception("Only one value is allowed at the top level of a "
+                      "document");
+    }
+    doc.nodes.emplace_back();
+    auto &node = doc.nodes.back();
+    node.type = type;
+    node.end = (uint32_t)doc.nodes.size();
+    node.key = pendingKey;
+    pendingKey = std::string_view();
+    return node;
+  }
+
+public:
+  Builder(JsonDocument &_doc, std::string_view _source)
+      : doc(_doc), source(_source), open(), pendingKey() {}
+
+  void startObject() {
+    add(JsonValueType::json);
+    open.push_back((uint32_t)(doc.nodes.size() - 1));
+  }
+
+  void endObject() {
+    doc.nodes[open.back()].end = (uint32_t)doc.nodes.size();
+    open.pop_back();
+  }
+
+  void startList() {
+    add(JsonValueType::list);
+    open.push_back((uint32_t)(doc.nodes.size() - 1));
+  }
+
+  void endList() { endObject(); }
+
+  void key(std::string_view val) { pendingKey = keep(val); }
+
+  void string(std::string_view val) {
+    add(JsonValueType::string).string = keep(val);
+  }
+
+  void integer(int64_t val) { add(JsonValueType::integer).integer = val; }
+
+  void decimal(double val) { add(JsonValueType::decimal).decimal = val; }
+
+  void boolean(bool val) { add(JsonValueType::boolean).boolean = val; }
+
+  void null() { add(JsonValueType::null); }
+};
+
+JsonDocument::JsonDocument(std::string _text)
+    : text(new std::string(std::move(_text))), file(), nodes(), decoded() {
+  build(*text);
+}
+
+JsonDocument::JsonDocument(MappedFile &&_file)
+    : text(), file(std::move(_file)), nodes(), decoded() {
+  build(file.view());
+}
+
+JsonDocument JsonDocument::fromFile(const std::string &path) {
+  return JsonDocument(MappedFile(path));
+}
+
+JsonDocument::JsonDocument(JsonDocument &&other) noexcept
+    : text(std::move(other.text)), file(std::move(other.file)),
+      nodes(std::move(other.nodes)), decoded(std::move(other.decoded)) {}
+
+JsonDocument &JsonDocument::operator=(JsonDocument &&other) noexcept {
+  text = std::move(other.text);
+  file = std::move(other.file);
+  nodes = std::move(other.nodes);
+  decoded = std::move(other.decoded);
+  return *this;
+}
+
+void JsonDocument::build(std::string_view source) {
+  auto builder = Builder(*this, source);
+  JsonParser::sax(source, builder);
+}
+
+JsonDocument::Element JsonDocument::root() const {
+  return Element(this, nodes.empty() ? -1 : 0);
+}
+
+JsonDocument::Element::Element(const JsonDocument *_doc, std::size_t _index)
+    : doc(_doc), index(_index) {}
+
+JsonValueType JsonDocument::Element::getType() const {
+  return isNone() ? JsonValueType::none : doc->nodes[index].type;
+}
+
+bool JsonDocument::Element::isInt() const {
+  return getType() == JsonValueType::integer;
+}
+
+int64_t JsonDocument::Element::asInt() const {
+  return doc->nodes[index].integer;
+}
+
+bool JsonDocument::Element::isDouble() const {
+  return getType() == JsonValueType::decimal;
+}
+
+double JsonDocument::Element::asDouble() const {
+  return doc->nodes[index].decimal;
+}
+
+bool JsonDocument::Element::isNull() const {
+  return getType() == JsonValueType::null;
+}
+
+bool JsonDocument::Element::isString() const {
+  return getType() == JsonValueType::string;
+}
+
+std::string_view JsonDocument::Element::asString() const {
+  return doc->nodes[index].string;
+}
+
+bool JsonDocument::Element::isBool() const {
+  return getType() == JsonValueType::boolean;
+}
+
+bool JsonDocument::Element::asBool() const {
+  return doc->nodes[index].boolean;
+}
+
+bool JsonDocument::Element::isJson() const {
+  return getType() == JsonValueType::json;
+}
+
+bool JsonDocument::Element::isList() const {
+  return getType() == JsonValueType::list;
+}
+
+bool JsonDocument::Element::isNone() const {
+  return index == (std::size_t)-1;
+}
+
+std::size_t JsonDocument::Element::size() const {
+  if (!isJson() && !isList()) {
+    return 0;
+  }
+  std::size_t result = 0;
+  auto &nodes = doc->nodes;
+  for (std::size_t i = index + 1; i < nodes[index].end; i = nodes[i].end) {
+    result++;
+  }
+  return result;
+}
+
+bool JsonDocument::Element::has(std::string_view key) const {
+  return !(*this)[key].isNone();
+}
+
+JsonDocument::Element
+JsonDocument::Element::operator[](std::string_view key) const {
+  // The whole object is walked, since the last member with the key is used
+  std::size_t found = -1;
+  if (isJson()) {
+    auto &nodes = doc->nodes;
+    for (std::size_t i = index + 1; i < nodes[index].end; i = nodes[i].end) {
+      if (nodes[i].key == key) {
+        found = i;
+      }
+    }
+  }
+  return Element(doc, found);
+}
+
+JsonDocument::Element JsonDocument::Element::at(std::size_t pos) const {
+  if (isList()) {
+    auto &nodes = doc->nodes;
+    for (std::size_t i = index + 1; i < nodes[index].end; i = nodes[i].end) {
+      if (pos == 0) {
+        return Element(doc, i);
+      }
+      pos--;
+    }
+  }
+  return Element(doc, -1);
+}
+
+JsonValue JsonDocument::Element::toJsonValue() const {
+  switch (getType()) {
+  case JsonValueType::integer: {
+    return JsonValue(asInt());
+  }
+  case JsonValueType::decimal: {
+    return JsonValue(asDouble());
+  }
+  case JsonValueType::string: {
+    return JsonValue(std::string(asString()));
+  }
+  case JsonValueType::boolean: {
+    return JsonValue(asBool());
+  }
+  case JsonValueType::null: {
+    return JsonValue();
+  }
+  case JsonValueType::json: {
+    auto result = Json();
+    auto &nodes = doc->nodes;
+    for (std::size_t i = index + 1; i < nodes[index].end; i = nodes[i].end) {
+      result[std::string(nodes[i].key)] = Element(doc, i).toJsonValue();
+    }
+    return JsonValue(std::move(result));
+  }
+  case JsonValueType::list: {
+    std::vector<JsonValue> result;
+    auto &nodes = doc->nodes;
+    for (std::size_t i = index + 1; i < nodes[index].end; i = nodes[i].end) {
+      result.push_back(Element(doc, i).toJsonValue());
+    }
+    return JsonValue(std::move(result));
+  }
+  case JsonValueType::none: {
+    return JsonValue::none();
+  }
+  }
+  return JsonValue::none();
+}
+
+} // namespace nuo
@@ -0,0 +1,265 @@
+#include "nuo/json_parser.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                             \
+    (defined(__GNUC__) || defined(__clang__))
+#define NUO_JSON_INDEX_X86 true
+#include <immintrin.h>
+#else
+#define NUO_JSON_INDEX_X86 false
+#endif
+
+namespace nuo {
+
+namespace {
+
+// Bitmasks of a 64 byte block, one bit for each byte
+class Masks {
+public:
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t whitespace;
+  uint64_t structural;
+};
+
+void classifyScalar(const char *block, Masks &masks) {
+  masks = Masks{0, 0, 0, 0};
+  for (unsigned i = 0; i < 64; i++) {
+    auto bit = uint64_t(1) << i;
+    switch (block[i]) {
+    case '"': {
+      masks.quote |= bit;
+      break;
+    }
+    case '\\': {
+      masks.backslash |= bit;
+      break;
+    }
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r': {
+      masks.whitespace |= bit;
+      break;
+    }
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',': {
+      masks.structural |= bit;
+      break;
+    }
+    default: {
+      break;
+    }
+    }
+  }
+}
+
+#if NUO_JSON_INDEX_X86
+
+__attribute__((target("avx2"))) uint64_t equalAvx2(__m256i lo, __m256i hi,
+                                                   char chr) {
+  auto wanted = _mm256_set1_epi8(chr);
+  uint32_t low = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, wanted));
+  uint32_t high = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, wanted));
+  return uint64_t(low) | (uint64_t(high) << 32);
+}
+
+__attribute__((target("avx2"))) void classifyAvx2(const char *block,
+                                                  Masks &masks) {
+  auto lo = _mm256_loadu_si256((const __m256i *)block);
+  auto hi = _mm256_loadu_si256((const __m256i *)(block + 32));
+  masks.quote = equalAvx2(lo, hi, '"');
+  masks.backslash = equalAvx2(lo, hi, '\\');
+  masks.whitespace = equalAvx2(lo, hi, ' ') | equalAvx2(lo, hi, '\t') |
+                     equalAvx2(lo, hi, '\n') | equalAvx2(lo, hi, '\r');
+  masks.structural = equalAvx2(lo, hi, '{') | equalAvx2(lo, hi, '}') |
+                     equalAvx2(lo, hi, '[') | equalAvx2(lo, hi, ']') |
+                     equalAvx2(lo, hi, ':') | equalAvx2(lo, hi, ',');
+}
+
+// Uses the string comparison instructions to match a set of characters
+__attribute__((target("sse4.2"))) uint64_t anyOfSse42(const char *block,
+                                                      __m128i set,
+                                                      int setLength) {
+  uint64_t result = 0;
+  for (unsigned i = 0; i < 4; i++) {
+    auto data = _mm_loadu_si128((const __m128i *)(block + (i * 16)));
+    auto mask = _mm_cmpestrm(set, setLength, data, 16,
+                             _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY |
+                                 _SIDD_BIT_MASK);
+    result |= (uint64_t)(uint16_t)_mm_cvtsi128_si32(mask) << (i * 16);
+  }
+  return result;
+}
+
+__attribute__((target("sse4.2"))) void classifySse42(const char *block,
+                                                    Masks &masks) {
+  const auto whitespace = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0,
+                                        0, 0, 0, 0, 0, 0, 0);
+  const auto structural = _mm_setr_epi8('{', '}', '[', ']', ':', ',', 0, 0, 0,
+                                        0, 0, 0, 0, 0, 0, 0);
+  const auto quote = _mm_set1_epi8('"');
+  const auto backslash = _mm_set1_epi8('\\');
+  masks.quote = 0;
+  masks.backslash = 0;
+  for (unsigned i = 0; i < 4; i++) {
+    auto data = _mm_loadu_si128((const __m128i *)(block + (i * 16)));
+    masks.quote |=
+        (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(data, quote))
+        << (i * 16);
+    masks.backslash |=
+        (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(data, backslash))
+        << (i * 16);
+  }
+  masks.whitespace = anyOfSse42(block, whitespace, 4);
+  masks.structural = anyOfSse42(block, structural, 6);
+}
+
+#endif
+
+using Classifier = void (*)(const char *, Masks &);
+
+Classifier pickClassifier() {
+#if NUO_JSON_INDEX_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return classifyAvx2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return classifySse42;
+  }
+#endif
+  return classifyScalar;
+}
+
+const Classifier classify = pickClassifier();
+
+// Each bit of the result is the parity of the bits up to and including it
+uint64_t prefixXor(uint64_t bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+} // namespace
+
+JsonParser::Index::Index(std::string_view val)
+    : text(), positions(), current(0), base(0), indexed(0), inString(0),
+      oddBackslash(0), scalarCarry(0), error() {
+  reset(val);
+}
+
+void JsonParser::Index::reset(std::string_view val) {
+  text = val;
+  positions.clear();
+  current = 0;
+  base = 0;
+  indexed = 0;
+  inString = 0;
+  oddBackslash = 0;
+  scalarCarry = 0;
+  error = JsonError();
+}
+
+void JsonParser::Index::seek(std::size_t pos) {
+  if ((pos >= base) && (pos < indexed)) {
+    current = std::lower_bound(positions.begin(), positions.end(),
+                               (uint32_t)(pos - base)) -
+              positions.begin();
+    return;
+  }
+  // A token starts outside strings and scalars, so nothing is carried over
+  // to the byte where indexing starts again
+  positions.clear();
+  current = 0;
+  base = pos;
+  indexed = pos;
+  inString = 0;
+  oddBackslash = 0;
+  scalarCarry = 0;
+}
+
+bool JsonParser::Index::next(std::size_t &pos) {
+  while (current == positions.size()) {
+    if (indexed >= text.size()) {
+      return false;
+    }
+    fill();
+  }
+  pos = base + positions[current];
+  current++;
+  return true;
+}
+
+void JsonParser::Index::fill() {
+  const uint64_t evenBits = 0x5555555555555555ULL;
+  positions.clear();
+  current = 0;
+  base = indexed;
+  auto end = text.size();
+  if ((end - base) > windowSize) {
+    end = base + windowSize;
+  }
+  char padded[64];
+  auto masks = Masks();
+  for (auto start = base; start < end; start += 64) {
+    auto block = text.data() + start;
+    if ((start + 64) > text.size()) {
+      std::memset(padded, ' ', 64);
+      std::memcpy(padded, block, text.size() - start);
+      block = padded;
+    }
+    classify(block, masks);
+
+    // Find the characters escaped by a backslash, which are the ones after a
+    // run of backslashes of odd length. Runs can continue from the previous
+    // block
+    auto backslash = masks.backslash;
+    auto startEdges = backslash & ~(backslash << 1);
+    auto evenStartMask = evenBits ^ oddBackslash;
+    auto evenStarts = startEdges & evenStartMask;
+    auto oddStarts = startEdges & ~evenStartMask;
+    auto evenCarries = backslash + evenStarts;
+    auto oddCarries = backslash + oddStarts;
+    auto endsOddBackslash = (oddCarries < backslash);
+    oddCarries |= oddBackslash;
+    oddBackslash = endsOddBackslash ? 1 : 0;
+    auto evenCarryEnds = evenCarries & ~backslash;
+    auto oddCarryEnds = oddCarries & ~backslash;
+    auto escaped =
+        (evenCarryEnds & ~evenBits) | (oddCarryEnds & evenBits);
+
+    // Bytes from an opening quote up to but not including the closing quote
+    auto quotes = masks.quote & ~escaped;
+    auto strings = prefixXor(quotes) ^ inString;
+    inString = (uint64_t)((int64_t)strings >> 63);
+
+    // Numbers and literals are runs of any other bytes outside strings, and
+    // only the first byte of a run is indexed
+    auto scalars =
+        ~(masks.structural | masks.whitespace | quotes | strings);
+    auto scalarStarts = scalars & ~((scalars << 1) | scalarCarry);
+    scalarCarry = scalars >> 63;
+
+    auto bits = (masks.structural & ~strings) | quotes | scalarStarts;
+    if ((start + 64) > text.size()) {
+      bits &= (uint64_t(1) << (text.size() - start)) - 1;
+    }
+    while (bits != 0) {
+      positions.push_back((uint32_t)(start - base + __builtin_ctzll(bits)));
+      bits &= bits - 1;
+    }
+  }
+  indexed = end;
+}
+
+} // namespace nuo
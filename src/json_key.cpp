@@ -0,0 +1,172 @@
+#include "nuo/json_key.hpp"
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace nuo {
+
+namespace {
+
+thread_local JsonKeyTable *currentTable = nullptr;
+
+const std::string emptyText;
+
+} // namespace
+
+class JsonKey::Table {
+public:
+  std::shared_mutex mutex;
+
+  // Views are into the text of the entries
+  std::unordered_map<std::string_view, JsonKey::Entry *> entries;
+};
+
+JsonKey::Entry::Entry(std::string_view _text, std::shared_ptr<Table> _table)
+    : references(1), table(std::move(_table)),
+      hash(std::hash<std::string_view>()(_text)), text(_text) {}
+
+JsonKey::JsonKey() : entry(nullptr) {}
+
+JsonKey::JsonKey(Entry *_entry) : entry(_entry) {
+  entry->references.fetch_add(1, std::memory_order_relaxed);
+}
+
+JsonKey::JsonKey(std::string_view text)
+    : JsonKey(JsonKeyTable::current().intern(text)) {}
+
+JsonKey::JsonKey(const JsonKey &other) noexcept : entry(other.entry) {
+  if (entry != nullptr) {
+    entry->references.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+JsonKey::JsonKey(JsonKey &&other) noexcept : entry(other.entry) {
+  other.entry = nullptr;
+}
+
+JsonKey &JsonKey::operator=(const JsonKey &other) noexcept {
+  if (entry != other.entry) {
+    auto copy = JsonKey(other);
+    std::swap(entry, copy.entry);
+  }
+  return *this;
+}
+
+JsonKey &JsonKey::operator=(JsonKey &&other) noexcept {
+  std::swap(entry, other.entry);
+  return *this;
+}
+
+JsonKey::~JsonKey() noexcept {
+  if (entry != nullptr) {
+    release();
+  }
+}
+
+void JsonKey::release() noexcept {
+  // Other references can be dropped without locking, but the last one is
+  // dropped while the table is locked, so that the entry cannot be found
+  // again while it is being removed
+  auto count = entry->references.load(std::memory_order_relaxed);
+  while (count > 1) {
+    if (entry->references.compare_exchange_weak(count, count - 1,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_relaxed)) {
+      return;
+    }
+  }
+  // Deleting the entry can drop the last reference to the table, which has
+  // to outlive the lock
+  auto table = entry->table;
+  auto lock = std::unique_lock(table->mutex);
+  if (entry->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    table->entries.erase(entry->text);
+    delete entry;
+  }
+}
+
+const std::string &JsonKey::text() const {
+  return (entry != nullptr) ? entry->text : emptyText;
+}
+
+std::size_t JsonKey::hash() const {
+  return (entry != nullptr) ? entry->hash : std::hash<std::string_view>()("");
+}
+
+bool JsonKey::operator==(const JsonKey &other) const {
+  if (entry == other.entry) {
+    return true;
+  }
+  if ((entry == nullptr) || (other.entry == nullptr) ||
+      (entry->table.get() == other.entry->table.get())) {
+    return false;
+  }
+  return entry->text == other.entry->text;
+}
+
+bool JsonKey::operator!=(const JsonKey &other) const {
+  return !(*this == other);
+}
+
+bool JsonKey::operator==(std::string_view other) const {
+  return (entry != nullptr) && (entry->text == other);
+}
+
+bool JsonKey::operator!=(std::string_view other) const {
+  return !(*this == other);
+}
+
+JsonKeyTable::JsonKeyTable() : table(std::make_shared<JsonKey::Table>()) {}
+
+JsonKeyTable::~JsonKeyTable() noexcept {}
+
+JsonKey JsonKeyTable::intern(std::string_view text) {
+  // Entries that are in the table have a reference, so taking another one
+  // while the table is locked cannot bring back an entry that is removed
+  {
+    auto lock = std::shared_lock(table->mutex);
+    auto found = table->entries.find(text);
+    if (found != table->entries.end()) {
+      return JsonKey(found->second);
+    }
+  }
+  auto lock = std::unique_lock(table->mutex);
+  auto found = table->entries.find(text);
+  if (found != table->entries.end()) {
+    return JsonKey(found->second);
+  }
+  auto entry = new JsonKey::Entry(text, table);
+  table->entries.emplace(entry->text, entry);
+  auto key = JsonKey();
+  key.entry = entry;
+  return key;
+}
+
+bool JsonKeyTable::contains(std::string_view text) const {
+  auto lock = std::shared_lock(table->mutex);
+  return table->entries.find(text) != table->entries.end();
+}
+
+std::size_t JsonKeyTable::size() const {
+  auto lock = std::shared_lock(table->mutex);
+  return table->entries.size();
+}
+
+JsonKeyTable &JsonKeyTable::global() {
+  static JsonKeyTable table;
+  return table;
+}
+
+JsonKeyTable &JsonKeyTable::current() {
+  return (currentTable != nullptr) ? *currentTable : global();
+}
+
+JsonKeyTable::Scope::Scope(JsonKeyTable &table) : previous(currentTable) {
+  currentTable = &table;
+}
+
+JsonKeyTable::Scope::~Scope() noexcept { currentTable = previous; }
+
+} // namespace nuo
@@ -0,0 +1,270 @@
+#include "nuo/json_lines.hpp"
+#include "nuo/exception.hpp"
+#include "nuo/json_parser.hpp"
+#include "nuo/mapped_file.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nuo {
+
+class JsonLines::Batch {
+public:
+  Batch()
+      : sequence(0), firstLine(1), owned(), text(), records(), lines(),
+        error() {}
+
+  // Position of the batch in the input
+  std::size_t sequence;
+
+  // Line number of the first line in the batch
+  std::size_t firstLine;
+
+  // Lines read from a stream. Lines of a mapped file are not copied
+  std::string owned;
+
+  std::string_view text;
+
+  std::vector<Json> records;
+
+  std::vector<std::size_t> lines;
+
+  // Problem found while parsing the batch. Records before it are kept
+  std::string error;
+
+  void parse(const JsonLimits &limits, JsonParser::KeyCache &keys) {
+    auto line = firstLine;
+    std::size_t start = 0;
+    while (start < text.size()) {
+      auto newline = text.find('\n', start);
+      auto end = (newline == std::string_view::npos) ? text.size() : newline;
+      auto record = text.substr(start, end - start);
+      start = end + 1;
+      if (record.find_first_not_of(" \t\r") != std::string_view::npos) {
+        auto parsed = Json();
+        auto problem = JsonError();
+        if (!JsonParser::tryParse(record, parsed, problem, limits, keys)) {
+          error = "Invalid Json at line " + std::to_string(line) + ": " +
+                  problem.message;
+          return;
+        }
+        records.push_back(std::move(parsed));
+        lines.push_back(line);
+      }
+      line++;
+    }
+  }
+};
+
+JsonLines::JsonLines(unsigned _workers, std::size_t _batchSize, bool _ordered,
+                     const JsonLimits &_limits)
+    : workers(_workers), batchSize(_batchSize), ordered(_ordered),
+      limits(_limits) {
+  if (workers == 0) {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  if (batchSize == 0) {
+    batchSize = 1;
+  }
+}
+
+void JsonLines::run(const std::function<bool(Batch &)> &nextBatch,
+                    const Consumer &consumer) const {
+  std::mutex mutex;
+  std::condition_variable jobReady;
+  std::condition_variable resultReady;
+  std::deque<std::unique_ptr<Batch>> jobs;
+  std::vector<std::unique_ptr<Batch>> results;
+  bool stop = false;
+
+  // Stops and joins the workers however this function exits
+  class Pool {
+  public:
+    std::vector<std::thread> threads;
+    std::mutex &mutex;
+    std::condition_variable &jobReady;
+    bool &stop;
+
+    ~Pool() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+      }
+      jobReady.notify_all();
+      for (auto &thread : threads) {
+        thread.join();
+      }
+    }
+  };
+  auto pool = Pool{{}, mutex, jobReady, stop};
+  // Keys are interned in the table of the calling thread. Each worker keeps
+  // its recent keys for all of its batches, so that the table is rarely
+  // locked when lines repeat their keys
+  auto &table = JsonKeyTable::current();
+  for (unsigned i = 0; i < workers; i++) {
+    pool.threads.emplace_back([&]() {
+      auto scope = JsonKeyTable::Scope(table);
+      auto keys = JsonParser::KeyCache();
+      while (true) {
+        std::unique_ptr<Batch> batch;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          jobReady.wait(lock, [&]() { return stop || !jobs.empty(); });
+          if (stop) {
+            return;
+          }
+          batch = std::move(jobs.front());
+          jobs.pop_front();
+        }
+        try {
+          batch->parse(limits, keys);
+        } catch (...) {
+          // Parsing reports problems without throwing, so this is only
+          // reached if memory could not be allocated
+          batch->error = "Failed to parse the batch starting at line " +
+                         std::to_string(batch->firstLine);
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          results.push_back(std::move(batch));
+        }
+        resultReady.notify_one();
+      }
+    });
+  }
+
+  auto deliver = [&](Batch &batch) {
+    for (std::size_t i = 0; i < batch.records.size(); i++) {
+      consumer(std::move(batch.records[i]), batch.lines[i]);
+    }
+    if (!batch.error.empty()) {
+      throw Exception(batch.error);
+    }
+  };
+
+  // Batches in flight are limited, so that memory use does not depend on the
+  // size of the input
+  const std::size_t maxInFlight = 2 * (std::size_t)workers;
+  std::size_t produced = 0;
+  std::size_t delivered = 0;
+  bool hasMore = true;
+  std::map<std::size_t, std::unique_ptr<Batch>> waiting;
+  std::vector<std::unique_ptr<Batch>> ready;
+  while (true) {
+    while (hasMore && ((produced - delivered) < maxInFlight)) {
+      auto batch = std::make_unique<Batch>();
+      if (!nextBatch(*batch)) {
+        hasMore = false;
+        break;
+      }
+      batch->sequence = produced++;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(batch));
+      }
+      jobReady.notify_one();
+    }
+    if (delivered == produced) {
+      break;
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      resultReady.wait(lock, [&]() { return !results.empty(); });
+      ready.swap(results);
+    }
+    for (auto &batch : ready) {
+      if (ordered) {
+        auto sequence = batch->sequence;
+        waiting[sequence] = std::move(batch);
+      } else {
+        delivered++;
+        deliver(*batch);
+      }
+    }
+    ready.clear();
+    while (!waiting.empty() && (waiting.begin()->first == delivered)) {
+      auto batch = std::move(waiting.begin()->second);
+      waiting.erase(waiting.begin());
+      delivered++;
+      deliver(*batch);
+    }
+  }
+}
+
+void JsonLines::read(std::istream &input, const Consumer &consumer) const {
+  std::string carry;
+  std::size_t line = 1;
+  run(
+      [&](Batch &batch) {
+        batch.owned = std::move(carry);
+        carry = std::string();
+        // Read until there is a complete line, or the end of the stream
+        auto newline = std::string::npos;
+        while (input) {
+          auto existing = batch.owned.size();
+          batch.owned.resize(existing + batchSize);
+          input.read(batch.owned.data() + existing, batchSize);
+          batch.owned.resize(existing + input.gcount());
+          // Only the bytes just read can have a newline, since the bytes
+          // before them are part of a line that has not ended
+          newline = std::string_view(batch.owned).substr(existing).rfind('\n');
+          if (newline != std::string::npos) {
+            newline += existing;
+            break;
+          }
+          // The whole batch is a single line so far
+          if ((limits.maxBytes != 0) &&
+              (batch.owned.size() > limits.maxBytes)) {
+            throw Exception("Invalid Json at line " + std::to_string(line) +
+                            ": Json text is larger than the limit of " +
+                            std::to_string(limits.maxBytes) + " bytes");
+          }
+        }
+        if (input && (newline != std::string::npos)) {
+          carry = batch.owned.substr(newline + 1);
+          batch.owned.resize(newline + 1);
+        }
+        if (batch.owned.empty()) {
+          return false;
+        }
+        batch.text = batch.owned;
+        batch.firstLine = line;
+        line += std::count(batch.text.begin(), batch.text.end(), '\n');
+        return true;
+      },
+      consumer);
+}
+
+void JsonLines::readFile(const std::string &path,
+                         const Consumer &consumer) const {
+  auto file = MappedFile(path);
+  auto text = file.view();
+  std::size_t pos = 0;
+  std::size_t line = 1;
+  run(
+      [&](Batch &batch) {
+        if (pos >= text.size()) {
+          return false;
+        }
+        auto end = std::min(pos + batchSize, text.size());
+        if (end < text.size()) {
+          auto newline = (const char *)std::memchr(text.data() + end, '\n',
+                                                   text.size() - end);
+          end = (newline == nullptr) ? text.size()
+                                     : (std::size_t)(newline - text.data()) + 1;
+        }
+        batch.text = text.substr(pos, end - pos);
+        batch.firstLine = line;
+        line += std::count(batch.text.begin(), batch.text.end(), '\n');
+        pos = end;
+        return true;
+      },
+      consumer);
+}
+
+} // namespace nuo
@@ -1,468 +1,1007 @@
 #include "nuo/json_parser.hpp"
 #include "nuo/exception.hpp"
 #include "nuo/json.hpp"
-#include <optional>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <thread>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace nuo {
 
-void JsonParser::lex(std::string val) {
-  const std::string digits = "0123456789";
-  const std::string alpha = "truefalsn";
-  for (std::size_t i = 0; i < val.size(); i++) {
-    auto chr = val.at(i);
-    if (chr == ' ' || chr == '\n' || chr == '\r' || chr == '\t') {
-      continue;
-    } else if (chr == '{') {
-      toks.push_back(Token(TokenType::curlyBraceOpen));
-    } else if (chr == '}') {
-      toks.push_back(Token(TokenType::curlyBraceClose));
-    } else if (chr == '[') {
-      toks.push_back(Token(TokenType::bracketOpen));
-    } else if (chr == ']') {
-      toks.push_back(Token(TokenType::bracketClose));
-    } else if (chr == ':') {
-      toks.push_back(Token(TokenType::colon));
-    } else if (chr == ',') {
-      toks.push_back(Token(TokenType::comma));
-    } else if (chr == '"') {
-      std::string str;
-      bool isEscape = false;
-      std::size_t j = i + 1;
-      for (; (isEscape ? true : val.at(j) != '"') && (j < val.size()); j++) {
-        if (isEscape) {
-          if (val.at(j) == '"') {
-            str += '"';
-          } else if (val.at(j) == 'b') {
-            str += '\b';
-          } else if (val.at(j) == 'f') {
-            str += '\f';
-          } else if (val.at(j) == 'n') {
-            str += '\n';
-          } else if (val.at(j) == 't') {
-            str += '\t';
-          } else if (val.at(j) == '\\') {
-            str += "\\";
-          } else {
-            throw(Exception("Wrong escape character found in json string"));
-          }
-          isEscape = false;
-        } else {
-          if (val.at(j) == '\\') {
-            isEscape = true;
-          } else {
-            str += val.at(j);
-          }
-        }
-      }
-      i = j;
-      toks.push_back(Token(TokenType::string, str));
-    } else if ((digits.find(val.at(i)) != std::string::npos) ||
-               (val.at(i) == '-')) {
-      bool isFloat = false;
-      std::string num(val.substr(i, 1));
-      std::string decimal;
-      std::size_t j = i + 1;
-      for (; ((isFloat ? (digits.find(val.at(j)) != std::string::npos)
-                       : ((digits.find(val.at(j)) != std::string::npos) ||
-                          (val.at(j) == '.'))) &&
-              (j < val.size()));
-           j++) {
-        if (isFloat) {
-          decimal += val.at(j);
-        } else {
-          if (val.at(j) != '.') {
-            num += val.at(j);
-          } else {
-            isFloat = true;
-          }
-        }
-      }
-      i = j - 1;
-      if (decimal.empty()) {
-        isFloat = false;
-      } else {
-        bool onlyZeroes = true;
-        for (auto dc : decimal) {
-          if (dc != '0') {
-            onlyZeroes = false;
-          }
-        }
-        isFloat = !onlyZeroes;
-      }
-      if (isFloat) {
-        toks.push_back(Token(TokenType::floating, num + '.' + decimal));
-      } else {
-        toks.push_back(Token(TokenType::integer, num));
-      }
-    } else if (alpha.find(val.at(i)) != std::string::npos) {
-      std::string idt(val.substr(i, 1));
-      std::size_t j = i + 1;
-      for (; ((alpha.find(val.at(j)) != std::string::npos) && (j < val.size()));
-           j++) {
-        idt += val.at(j);
-      }
-      if (idt == "true") {
-        toks.push_back(Token(TokenType::True));
-      } else if (idt == "false") {
-        toks.push_back(Token(TokenType::False));
-      } else if (idt == "null") {
-        toks.push_back(Token(TokenType::null));
-      } else {
-        throw Exception("Invalid symbol found `" + idt + "` at " +
-                        std::to_string(i));
+// Handler that assembles the reported values into a Json tree. Objects at the
+// top level are either merged into a Json, or there is a single value of any
+// type at the top level
+class JsonParser::TreeBuilder {
+private:
+  class Frame {
+  public:
+    Frame(bool _isList) : isList(_isList), object(), list(), key() {}
+
+    bool isList;
+    Json object;
+    std::vector<JsonValue> list;
+    JsonKey key;
+  };
+
+  std::vector<Frame> stack;
+
+  bool merge;
+
+  KeyCache &keys;
+
+  void add(JsonValue &&value) {
+    if (stack.empty()) {
+      if (!root.isNone()) {
+        throw Exception("Only one value is allowed at the top level");
       }
-      i = j - 1;
+      root = std::move(value);
+      return;
+    }
+    auto &parent = stack.back();
+    if (parent.isList) {
+      parent.list.push_back(std::move(value));
     } else {
-      throw Exception("Invalid symbol found at " + std::to_string(i));
+      parent.object.slot(parent.key) = std::move(value);
     }
   }
-}
 
-bool JsonParser::isNext(TokenType type, std::size_t i = 0) const {
-  return (i < toks.size()) ? (toks.at(i + 1).type == type) : false;
-}
+public:
+  TreeBuilder(bool _merge, KeyCache &_keys)
+      : stack(), merge(_merge), keys(_keys), result(),
+        root(JsonValue::none()) {}
 
-std::optional<std::size_t>
-JsonParser::getPairEnd(const bool isList, const std::size_t from,
-                       const std::optional<std::size_t> to) const {
-  unsigned collisions = 0;
-  for (std::size_t i = from + 1;
-       ((to.has_value() ? (i < to.value()) : true) && (i < toks.size())); i++) {
-    auto tok = toks.at(i);
-    if (isList) {
-      if (tok.type == TokenType::bracketOpen) {
-        collisions++;
-      } else if (tok.type == TokenType::bracketClose) {
-        if (collisions > 0) {
-          collisions--;
-        } else {
-          return i;
-        }
-      }
+  // Objects at the top level, if they are merged
+  Json result;
+
+  // The value at the top level, if they are not merged
+  JsonValue root;
+
+  void startObject() { stack.push_back(Frame(false)); }
+
+  void endObject() {
+    auto object = std::move(stack.back().object);
+    stack.pop_back();
+    if (!stack.empty() || !merge) {
+      add(JsonValue(std::move(object)));
+    } else if (result.keys.empty()) {
+      result = std::move(object);
     } else {
-      if (tok.type == TokenType::curlyBraceOpen) {
-        collisions++;
-      } else if (tok.type == TokenType::curlyBraceClose) {
-        if (collisions > 0) {
-          collisions--;
-        } else {
-          return i;
-        }
+      for (std::size_t i = 0; i < object.keys.size(); i++) {
+        result.slot(object.keys[i]) = std::move(object.values[i]);
       }
     }
   }
-  return std::nullopt;
+
+  void startList() { stack.push_back(Frame(true)); }
+
+  void endList() {
+    auto list = std::move(stack.back().list);
+    stack.pop_back();
+    add(JsonValue(std::move(list)));
+  }
+
+  // Take the elements of the outermost list, which is still open
+  std::vector<JsonValue> takeList() { return std::move(stack.front().list); }
+
+  void key(std::string_view key) { stack.back().key = keys.intern(key); }
+
+  void string(std::string_view val) { add(JsonValue(val)); }
+
+  void integer(int64_t val) { add(JsonValue(val)); }
+
+  void decimal(double val) { add(JsonValue(val)); }
+
+  void boolean(bool val) { add(JsonValue(val)); }
+
+  void null() { add(JsonValue()); }
+};
+
+JsonParser::KeyCache::KeyCache() : keys() {}
+
+const JsonKey &JsonParser::KeyCache::intern(std::string_view key) {
+  auto &cached = keys[std::hash<std::string_view>()(key) % keys.size()];
+  if (cached != key) {
+    cached = JsonKeyTable::current().intern(key);
+  }
+  return cached;
 }
 
-bool JsonParser::hasPrimaryCommas(std::size_t from, std::size_t to) const {
-  for (std::size_t i = from + 1; i < to; i++) {
-    auto tok = toks.at(i);
-    switch (tok.type) {
-    case TokenType::curlyBraceOpen:
-    case TokenType::bracketOpen: {
-      bool isList = (tok.type == TokenType::bracketOpen);
-      auto bCloseRes = getPairEnd(isList, i, to);
-      if (bCloseRes.has_value()) {
-        i = bCloseRes.value();
-      } else {
-        throw Exception(std::string("End for ") + (isList ? "[" : "{") +
-                        " could not be found");
-      }
+JsonParser::JsonParser(bool _objectRoot, const JsonLimits &_limits)
+    : open(), expect(Expect::value), lastValue(""), objectRoot(_objectRoot),
+      error(), limits(_limits), limited(_limits.has()), allocated(0),
+      countedKeys(), objects() {}
+
+namespace {
+
+bool isDigit(char chr) { return (chr >= '0') && (chr <= '9'); }
+
+bool isLiteral(char chr) {
+  switch (chr) {
+  case 't':
+  case 'r':
+  case 'u':
+  case 'e':
+  case 'f':
+  case 'a':
+  case 'l':
+  case 's':
+  case 'n': {
+    return true;
+  }
+  default: {
+    return false;
+  }
+  }
+}
+
+// Numbers and literals should be followed by whitespace, a structural
+// character, a quote or the end of the text
+bool checkScalarEnd(std::string_view val, std::size_t j, JsonError &error) {
+  if (j < val.size()) {
+    switch (val[j]) {
+    case ' ':
+    case '\n':
+    case '\r':
+    case '\t':
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+    case '"': {
       break;
     }
-    case TokenType::comma: {
-      return true;
-    }
     default: {
-      continue;
+      error.kind = JsonErrorKind::invalidSymbol;
+      error.offset = j;
+      error.message = "Invalid symbol found at " + std::to_string(j);
+      return false;
     }
     }
   }
-  return false;
+  return true;
 }
 
-std::vector<std::size_t> JsonParser::getPrimaryCommas(std::size_t from,
-                                                      std::size_t to) const {
-  std::vector<std::size_t> result;
-  for (std::size_t i = from + 1; i < to; i++) {
-    auto tok = toks.at(i);
-    switch (tok.type) {
-    case TokenType::curlyBraceOpen:
-    case TokenType::bracketOpen: {
-      bool isList = (tok.type == TokenType::bracketOpen);
-      auto bCloseRes = getPairEnd(isList, i, to);
-      if (bCloseRes.has_value()) {
-        i = bCloseRes.value();
-      } else {
-        throw Exception(std::string("End for ") + (isList ? "[" : "{") +
-                        " could not be found");
+// Handler used when only validating the text
+class Validator {
+public:
+  void startObject() {}
+  void endObject() {}
+  void startList() {}
+  void endList() {}
+  void key(std::string_view key) {}
+  void string(std::string_view val) {}
+  void integer(int64_t val) {}
+  void decimal(double val) {}
+  void boolean(bool val) {}
+  void null() {}
+};
+
+// Position of the first byte that is not part of valid UTF-8 in the text, or
+// the size of the text if all of it is valid. Runs of ASCII are skipped 16
+// bytes at a time, and only the other bytes are decoded one at a time
+std::size_t findInvalidUtf8(const char *data, std::size_t size) {
+  std::size_t i = 0;
+  auto continues = [&](std::size_t pos, unsigned char low, unsigned char high) {
+    if (pos >= size) {
+      return false;
+    }
+    auto chr = (unsigned char)data[pos];
+    return (chr >= low) && (chr <= high);
+  };
+  while (i < size) {
+#if defined(__SSE2__)
+    while ((i + 16 <= size) &&
+           (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(data + i))) ==
+            0)) {
+      i += 16;
+    }
+#else
+    while (i + 8 <= size) {
+      uint64_t block;
+      std::memcpy(&block, data + i, 8);
+      if ((block & 0x8080808080808080ULL) != 0) {
+        break;
       }
-      break;
+      i += 8;
     }
-    case TokenType::comma: {
-      result.push_back(i);
+#endif
+    for (; (i < size) && ((unsigned char)data[i] < 0x80); i++) {
+    }
+    if (i == size) {
       break;
     }
-    default: {
-      continue;
+    // The ranges of valid sequences, from table 3-7 of the Unicode standard
+    auto lead = (unsigned char)data[i];
+    std::size_t length = 0;
+    if ((lead >= 0xC2) && (lead <= 0xDF)) {
+      length = continues(i + 1, 0x80, 0xBF) ? 2 : 0;
+    } else if ((lead >= 0xE0) && (lead <= 0xEF)) {
+      auto low = (lead == 0xE0) ? 0xA0 : 0x80;
+      auto high = (lead == 0xED) ? 0x9F : 0xBF;
+      length =
+          (continues(i + 1, low, high) && continues(i + 2, 0x80, 0xBF)) ? 3 : 0;
+    } else if ((lead >= 0xF0) && (lead <= 0xF4)) {
+      auto low = (lead == 0xF0) ? 0x90 : 0x80;
+      auto high = (lead == 0xF4) ? 0x8F : 0xBF;
+      length = (continues(i + 1, low, high) && continues(i + 2, 0x80, 0xBF) &&
+                continues(i + 3, 0x80, 0xBF))
+                   ? 4
+                   : 0;
+    }
+    if (length == 0) {
+      return i;
+    }
+    i += length;
+  }
+  return size;
+}
+
+// Position of the first byte below 0x20 in the text, or the size of the text
+// if there is none. Control characters have to be escaped in Json strings
+std::size_t findControlCharacter(const char *data, std::size_t size) {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  auto space = _mm_set1_epi8(0x20);
+  while (i + 16 <= size) {
+    auto chunk = _mm_loadu_si128((const __m128i *)(data + i));
+    // Bytes are at least 0x20 where the unsigned maximum leaves them as is
+    auto printable = _mm_cmpeq_epi8(_mm_max_epu8(chunk, space), chunk);
+    if (_mm_movemask_epi8(printable) != 0xFFFF) {
+      break;
     }
+    i += 16;
+  }
+#endif
+  for (; (i < size) && ((unsigned char)data[i] >= 0x20); i++) {
+  }
+  return i;
+}
+
+// Value of the 4 hexadecimal digits at `pos`, or -1 if they are not valid
+int32_t readHex4(std::string_view val, std::size_t pos, std::size_t end) {
+  if (pos + 4 > end) {
+    return -1;
+  }
+  int32_t result = 0;
+  for (auto i = pos; i < pos + 4; i++) {
+    auto chr = val[i];
+    result <<= 4;
+    if (isDigit(chr)) {
+      result |= chr - '0';
+    } else if ((chr >= 'a') && (chr <= 'f')) {
+      result |= chr - 'a' + 10;
+    } else if ((chr >= 'A') && (chr <= 'F')) {
+      result |= chr - 'A' + 10;
+    } else {
+      return -1;
     }
   }
   return result;
 }
 
-JsonValue JsonParser::parseValue(std::size_t from, std::size_t to) const {
-  for (std::size_t i = from + 1; i < to; i++) {
-    auto &tok = toks.at(i);
-    switch (tok.type) {
-    case TokenType::True:
-    case TokenType::False: {
-      return JsonValue(tok.type == TokenType::True);
-    }
-    case TokenType::curlyBraceOpen: {
-      auto bCloseRes = getPairEnd(false, i, to);
-      if (bCloseRes.has_value()) {
-        return parse(i - 1, bCloseRes.value() + 1);
-      } else {
-        throw Exception("End for { could not be found for value");
+// Decode the unicode escape sequence starting at the backslash at `slash`,
+// which might be followed by a second one for a surrogate pair. Returns the
+// number of bytes in the escape sequences, or 0 if they are not valid
+std::size_t decodeUnicode(std::string_view val, std::size_t slash,
+                          std::size_t end, std::string &str) {
+  auto unit = readHex4(val, slash + 2, end);
+  if ((unit < 0) || ((unit >= 0xDC00) && (unit <= 0xDFFF))) {
+    return 0;
+  }
+  uint32_t code = unit;
+  std::size_t length = 6;
+  if ((unit >= 0xD800) && (unit <= 0xDBFF)) {
+    auto low = -1;
+    if ((slash + 7 < end) && (val[slash + 6] == '\\') &&
+        (val[slash + 7] == 'u')) {
+      low = readHex4(val, slash + 8, end);
+    }
+    if ((low < 0xDC00) || (low > 0xDFFF)) {
+      return 0;
+    }
+    code = 0x10000 + (((uint32_t)unit - 0xD800) << 10) +
+           ((uint32_t)low - 0xDC00);
+    length = 12;
+  }
+  if (code < 0x80) {
+    str += (char)code;
+  } else if (code < 0x800) {
+    str += (char)(0xC0 | (code >> 6));
+    str += (char)(0x80 | (code & 0x3F));
+  } else if (code < 0x10000) {
+    str += (char)(0xE0 | (code >> 12));
+    str += (char)(0x80 | ((code >> 6) & 0x3F));
+    str += (char)(0x80 | (code & 0x3F));
+  } else {
+    str += (char)(0xF0 | (code >> 18));
+    str += (char)(0x80 | ((code >> 12) & 0x3F));
+    str += (char)(0x80 | ((code >> 6) & 0x3F));
+    str += (char)(0x80 | (code & 0x3F));
+  }
+  return length;
+}
+
+// Lex the number starting at `i`, following the grammar of RFC 8259. The
+// value is converted directly from the text. Integers in the range of int64_t
+// are kept exact, and any other number becomes a double. A fraction of only
+// zeroes without an exponent still gives an integer. Returns false if the
+// number is not valid
+bool lexNumber(std::string_view val, std::size_t i, JsonParser::Token &tok,
+               JsonError &error) {
+  auto invalid = [&]() {
+    error.kind = JsonErrorKind::invalidNumber;
+    error.offset = i;
+    error.message = "Invalid number found at " + std::to_string(i);
+    return false;
+  };
+  std::size_t j = i;
+  bool negative = (val[j] == '-');
+  if (negative) {
+    j++;
+  }
+  auto intStart = j;
+  if ((j < val.size()) && (val[j] == '0')) {
+    j++;
+  } else if ((j < val.size()) && isDigit(val[j])) {
+    for (j++; (j < val.size()) && isDigit(val[j]); j++) {
+    }
+  } else {
+    return invalid();
+  }
+  auto intEnd = j;
+  bool onlyZeroes = true;
+  if ((j < val.size()) && (val[j] == '.')) {
+    auto fractionStart = ++j;
+    for (; (j < val.size()) && isDigit(val[j]); j++) {
+      if (val[j] != '0') {
+        onlyZeroes = false;
       }
     }
-    case TokenType::curlyBraceClose: {
-      throw Exception("Invalid } found");
-    }
-    case TokenType::string: {
-      return JsonValue(tok.value);
+    if (j == fractionStart) {
+      return invalid();
     }
-    case TokenType::integer: {
-      return JsonValue(std::stoi(tok.value));
+  }
+  bool hasExponent = false;
+  bool negativeExponent = false;
+  if ((j < val.size()) && ((val[j] == 'e') || (val[j] == 'E'))) {
+    hasExponent = true;
+    j++;
+    if ((j < val.size()) && ((val[j] == '+') || (val[j] == '-'))) {
+      negativeExponent = (val[j] == '-');
+      j++;
     }
-    case TokenType::floating: {
-      return JsonValue(std::stod(tok.value));
+    auto exponentStart = j;
+    for (; (j < val.size()) && isDigit(val[j]); j++) {
     }
-    case TokenType::comma: {
-      throw Exception("Invalid , found");
+    if (j == exponentStart) {
+      return invalid();
     }
-    case TokenType::colon: {
-      throw Exception("Invalid : found");
+  }
+  if (!checkScalarEnd(val, j, error)) {
+    return false;
+  }
+  tok.length = j - i;
+  // Up to 19 digits cannot overflow uint64_t, so only the sign is checked
+  if (onlyZeroes && !hasExponent && ((intEnd - intStart) <= 19)) {
+    uint64_t magnitude = 0;
+    for (auto k = intStart; k < intEnd; k++) {
+      magnitude = (magnitude * 10) + (uint64_t)(val[k] - '0');
+    }
+    auto limit = (uint64_t)INT64_MAX + (negative ? 1 : 0);
+    if (magnitude <= limit) {
+      tok.integer = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+      tok.type = JsonParser::TokenType::integer;
+      return true;
     }
-    case TokenType::null: {
-      return JsonValue();
+  }
+  auto result = std::from_chars(val.data() + i, val.data() + j, tok.decimal);
+  if (result.ec == std::errc::result_out_of_range) {
+    if (!hasExponent || !negativeExponent) {
+      error.kind = JsonErrorKind::numberOutOfRange;
+      error.offset = i;
+      error.message = "Number is out of range at " + std::to_string(i);
+      return false;
+    }
+    // Too small to be represented, so it is rounded to zero
+    tok.decimal = negative ? -0.0 : 0.0;
+  } else if (result.ec != std::errc()) {
+    return invalid();
+  }
+  tok.type = JsonParser::TokenType::floating;
+  return true;
+}
+
+} // namespace
+
+bool JsonParser::lexNext(Index &index, Token &tok) {
+  std::size_t i = 0;
+  if (!index.next(i)) {
+    return false;
+  }
+  auto val = index.text;
+  auto chr = val[i];
+  tok.value.clear();
+  tok.offset = i;
+  tok.length = 1;
+  switch (chr) {
+  case '{': {
+    tok.type = TokenType::curlyBraceOpen;
+    break;
+  }
+  case '}': {
+    tok.type = TokenType::curlyBraceClose;
+    break;
+  }
+  case '[': {
+    tok.type = TokenType::bracketOpen;
+    break;
+  }
+  case ']': {
+    tok.type = TokenType::bracketClose;
+    break;
+  }
+  case ':': {
+    tok.type = TokenType::colon;
+    break;
+  }
+  case ',': {
+    tok.type = TokenType::comma;
+    break;
+  }
+  case '"': {
+    // The closing quote is the next indexed position, since nothing inside a
+    // string is indexed
+    std::size_t end = 0;
+    if (!index.next(end)) {
+      return fail(index.error, JsonErrorKind::unexpectedEnd, i,
+                  "End for \" could not be found");
+    }
+    tok.type = TokenType::string;
+    tok.length = end + 1 - i;
+    std::size_t j = i + 1;
+    auto invalidUtf8 = findInvalidUtf8(val.data() + j, end - j);
+    if (invalidUtf8 != end - j) {
+      return fail(index.error, JsonErrorKind::invalidUtf8, j + invalidUtf8,
+                  "Invalid UTF-8 found in json string at " +
+                      std::to_string(j + invalidUtf8));
+    }
+    auto control = findControlCharacter(val.data() + j, end - j);
+    if (control != end - j) {
+      return fail(index.error, JsonErrorKind::controlCharacter, j + control,
+                  "Control character found in json string at " +
+                      std::to_string(j + control));
+    }
+    auto escape = (const char *)std::memchr(val.data() + j, '\\', end - j);
+    if (escape == nullptr) {
+      // Nothing to decode, so the contents are not copied
+      tok.view = val.substr(j, end - j);
+      break;
     }
-    case TokenType::bracketOpen: {
-      auto bCloseRes = getPairEnd(true, i, to);
-      if (bCloseRes.has_value()) {
-        auto bClose = bCloseRes.value();
-        std::vector<JsonValue> vals;
-        if (hasPrimaryCommas(i, bClose)) {
-          auto sepPos = getPrimaryCommas(i, bClose);
-          vals.push_back(parseValue(i, sepPos.front()));
-          for (std::size_t j = 0; j < (sepPos.size() - 1); j++) {
-            vals.push_back(parseValue(sepPos.at(j), sepPos.at(j + 1)));
-          }
-          vals.push_back(parseValue(sepPos.back(), bClose));
-        } else if (i != bClose) {
-          vals.push_back(parseValue(i, bClose));
+    auto &str = tok.value;
+    while (true) {
+      auto slash = (std::size_t)(escape - val.data());
+      str.append(val.data() + j, slash - j);
+      std::size_t length = 2;
+      switch (val[slash + 1]) {
+      case '"': {
+        str += '"';
+        break;
+      }
+      case 'b': {
+        str += '\b';
+        break;
+      }
+      case 'f': {
+        str += '\f';
+        break;
+      }
+      case 'n': {
+        str += '\n';
+        break;
+      }
+      case 't': {
+        str += '\t';
+        break;
+      }
+      case 'r': {
+        str += '\r';
+        break;
+      }
+      case '\\': {
+        str += '\\';
+        break;
+      }
+      case '/': {
+        str += '/';
+        break;
+      }
+      case 'u': {
+        length = decodeUnicode(val, slash, end, str);
+        if (length == 0) {
+          return fail(index.error, JsonErrorKind::invalidEscape, slash,
+                      "Invalid unicode escape found in json string");
         }
-        return JsonValue(vals);
-      } else {
-        throw Exception("End for [ could not be found for value");
+        break;
+      }
+      default: {
+        return fail(index.error, JsonErrorKind::invalidEscape, slash,
+                    "Wrong escape character found in json string");
+      }
+      }
+      j = slash + length;
+      escape = (const char *)std::memchr(val.data() + j, '\\', end - j);
+      if (escape == nullptr) {
+        str.append(val.data() + j, end - j);
+        break;
       }
     }
-    case TokenType::bracketClose:
-      throw Exception("Invalid ] found");
+    tok.view = str;
+    break;
+  }
+  default: {
+    if (isDigit(chr) || (chr == '-')) {
+      if (!lexNumber(val, i, tok, index.error)) {
+        return false;
+      }
+    } else if (isLiteral(chr)) {
+      std::size_t j = i + 1;
+      for (; (j < val.size()) && isLiteral(val[j]); j++) {
+      }
+      auto idt = val.substr(i, j - i);
+      if (idt == "true") {
+        tok.type = TokenType::True;
+      } else if (idt == "false") {
+        tok.type = TokenType::False;
+      } else if (idt == "null") {
+        tok.type = TokenType::null;
+      } else {
+        return fail(index.error, JsonErrorKind::invalidSymbol, i,
+                    "Invalid symbol found `" + std::string(idt) + "` at " +
+                        std::to_string(i));
+      }
+      if (!checkScalarEnd(val, j, index.error)) {
+        return false;
+      }
+      tok.length = j - i;
+    } else {
+      return fail(index.error, JsonErrorKind::invalidSymbol, i,
+                  "Invalid symbol found at " + std::to_string(i));
     }
+    break;
   }
-  return JsonValue::none();
+  }
+  return true;
 }
 
-std::vector<std::pair<std::string, JsonValue>>
-JsonParser::parsePairs(std::size_t from, std::size_t to) const {
-  std::vector<std::pair<std::string, JsonValue>> result;
-  for (std::size_t i = from + 1; i < to; i++) {
-    auto tok = toks.at(i);
-    if (tok.type == TokenType::string) {
-      if (isNext(TokenType::colon, i)) {
-        switch (toks.at(i + 2).type) {
-        case TokenType::True:
-        case TokenType::False: {
-          if (isNext(TokenType::comma, i + 2) ||
-              isNext(TokenType::curlyBraceClose, i + 2)) {
-            result.push_back(std::pair(tok.value, parseValue(i + 1, i + 3)));
-            i += 2;
-            break;
-          } else {
-            throw Exception("Invalid token found after boolean");
-          }
-        }
-        case TokenType::curlyBraceOpen: {
-          auto bCloseRes = getPairEnd(false, i + 2, to);
-          if (bCloseRes.has_value()) {
-            auto bClose = bCloseRes.value();
-            if (isNext(TokenType::comma, bClose) ||
-                isNext(TokenType::curlyBraceClose, bClose)) {
-              result.push_back(std::pair(tok.value, parse(i + 1, bClose + 1)));
-              i = bClose;
-              break;
-            } else {
-              throw Exception("Invalid token found after Json object");
-            }
-          } else {
-            throw Exception("End for { could not be found while parsing pairs");
-          }
-        }
-        case TokenType::curlyBraceClose: {
-          throw Exception("Invalid } found");
-        }
-        case TokenType::string: {
-          if (isNext(TokenType::comma, i + 2) ||
-              isNext(TokenType::curlyBraceClose, i + 2)) {
-            result.push_back(std::pair(tok.value, parseValue(i + 1, i + 3)));
-            i += 2;
-            break;
-          } else {
-            throw Exception("Invalid token found after string");
-          }
-        }
-        case TokenType::integer: {
-          if (isNext(TokenType::comma, i + 2) ||
-              isNext(TokenType::curlyBraceClose, i + 2)) {
-            result.push_back(std::pair(tok.value, parseValue(i + 1, i + 3)));
-            i += 2;
-            break;
-          } else {
-            throw Exception("Invalid token found after integer");
-          }
-        }
-        case TokenType::floating: {
-          if (isNext(TokenType::comma, i + 2) ||
-              isNext(TokenType::curlyBraceClose, i + 2)) {
-            result.push_back(std::pair(tok.value, parseValue(i + 1, i + 3)));
-            i += 2;
-            break;
-          } else {
-            throw Exception("Invalid token found after floating point number");
-          }
-        }
-        case TokenType::bracketOpen: {
-          auto bCloseRes = getPairEnd(true, i + 2, to);
-          if (bCloseRes.has_value()) {
-            auto bClose = bCloseRes.value();
-            if (isNext(TokenType::comma, bClose) ||
-                isNext(TokenType::curlyBraceClose, bClose)) {
-              result.push_back(
-                  std::pair(tok.value, parseValue(i + 1, bClose + 1)));
-              i = bClose;
-              break;
-            } else {
-              throw Exception("Invalid token found after list");
-            }
-          } else {
-            throw Exception("End for [ could not be found while parsing pair");
-          }
-        }
-        case TokenType::null: {
-          if (isNext(TokenType::comma, i + 2) ||
-              isNext(TokenType::curlyBraceClose, i + 2)) {
-            result.push_back(std::pair(tok.value, JsonValue()));
-            i += 2;
-            break;
-          } else {
-            throw Exception("Invalid token found after null");
-          }
-        }
-        case TokenType::comma: {
-          throw Exception("Invalid , found");
-        }
-        case TokenType::colon: {
-          throw Exception("Invalid : found");
+bool JsonParser::rejectRoot(const Token &tok) {
+  const char *message = "";
+  switch (tok.type) {
+  case TokenType::False: {
+    message = "false should not occur outside Json scope";
+    break;
+  }
+  case TokenType::True: {
+    message = "true should not occur outside Json scope";
+    break;
+  }
+  case TokenType::curlyBraceOpen:
+  case TokenType::curlyBraceClose: {
+    return true;
+  }
+  case TokenType::string: {
+    message = "String should not occur outside Json scope";
+    break;
+  }
+  case TokenType::integer: {
+    message = "Integer should not occur outside Json scope";
+    break;
+  }
+  case TokenType::floating: {
+    message = "Float number should not occur outside Json scope";
+    break;
+  }
+  case TokenType::comma: {
+    message = "Comma should not occur outside Json scope";
+    break;
+  }
+  case TokenType::colon: {
+    message = "Colon should not occur outside Json scope";
+    break;
+  }
+  case TokenType::null: {
+    message = "Null should not occur outside Json scope";
+    break;
+  }
+  case TokenType::bracketOpen: {
+    message = "List should not begin outside Json scope";
+    break;
+  }
+  case TokenType::bracketClose: {
+    message = "] should not occur outside Json scope";
+    break;
+  }
+  }
+  return fail(error, JsonErrorKind::unexpectedToken, tok.offset, message);
+}
+
+bool JsonParser::finish(std::size_t end) {
+  if (!open.empty()) {
+    return fail(error, JsonErrorKind::unexpectedEnd, end,
+                std::string("End for ") + (open.back() ? "[" : "{") +
+                    " could not be found");
+  }
+  return true;
+}
+
+namespace {
+
+// Heap memory used by a string of the provided length, beyond the string
+// itself. Short strings are stored inline
+std::size_t stringFootprint(std::size_t length) {
+  return (length < sizeof(std::string)) ? 0 : length + 1;
+}
+
+} // namespace
+
+bool JsonParser::checkLimits(const Token &tok, bool isKey) {
+  if ((limits.maxBytes != 0) && (tok.offset + tok.length > limits.maxBytes)) {
+    return fail(error, JsonErrorKind::sizeLimit, tok.offset,
+                "Json text is larger than the limit of " +
+                    std::to_string(limits.maxBytes) + " bytes");
+  }
+  if ((limits.maxStringLength != 0) && (tok.type == TokenType::string) &&
+      (tok.view.size() > limits.maxStringLength)) {
+    return fail(error, JsonErrorKind::stringLimit, tok.offset,
+                std::string(isKey ? "Key" : "String") +
+                    " is longer than the limit of " +
+                    std::to_string(limits.maxStringLength) + " bytes");
+  }
+  bool opens = (tok.type == TokenType::curlyBraceOpen) ||
+               (tok.type == TokenType::bracketOpen);
+  if ((limits.maxDepth != 0) && opens && (open.size() >= limits.maxDepth)) {
+    return fail(error, JsonErrorKind::depthLimit, tok.offset,
+                "Json is nested deeper than the limit of " +
+                    std::to_string(limits.maxDepth));
+  }
+  if (limits.maxAllocation != 0) {
+    // A key is a handle in the object, and a value is a JsonValue in its
+    // container. The text of a key is in its entry of the key table, which
+    // is only created for a key that is not in the table yet. Objects, lists
+    // and strings that are too long to be inline are allocated separately.
+    // Objects with many keys also have an index, which grows like it does
+    // when the keys are added to the Json
+    if (isKey) {
+      allocated += sizeof(JsonKey);
+      if (countedKeys.insert(std::string(tok.view)).second &&
+          !JsonKeyTable::current().contains(tok.view)) {
+        allocated += sizeof(std::string) + stringFootprint(tok.view.size());
+      }
+      auto &object = objects.back();
+      object.keys++;
+      if (object.keys > (object.slots / 2)) {
+        auto slots = Json::indexSlots(object.keys);
+        if (slots > object.slots) {
+          allocated += (slots - object.slots) * sizeof(uint32_t);
+          object.slots = slots;
         }
-        case TokenType::bracketClose:
-          throw Exception("Invalid ] found");
+      }
+    } else if (tok.type == TokenType::curlyBraceClose) {
+      // A brace that does not close an object is rejected by the grammar
+      if (!objects.empty()) {
+        objects.pop_back();
+      }
+    } else if (tok.type != TokenType::bracketClose) {
+      allocated += sizeof(JsonValue);
+      switch (tok.type) {
+      case TokenType::curlyBraceOpen: {
+        allocated += sizeof(Json);
+        objects.emplace_back();
+        break;
+      }
+      case TokenType::bracketOpen: {
+        allocated += sizeof(std::vector<JsonValue>);
+        break;
+      }
+      case TokenType::string: {
+        if (tok.view.size() > JsonValue::maxInline) {
+          allocated += sizeof(std::string) + stringFootprint(tok.view.size());
         }
-      } else {
-        Exception("Colon expected after the key");
+        break;
       }
-    } else if (tok.type == TokenType::comma) {
-      if (!isNext(TokenType::string, i)) {
-        throw Exception("Trailing commas are not allowed. Expected a key "
-                        "after the comma");
+      default: {
+        break;
       }
-    } else {
-      throw Exception("Illegal token found inside Json scope");
+      }
+    }
+    if (allocated > limits.maxAllocation) {
+      return fail(error, JsonErrorKind::allocationLimit, tok.offset,
+                  "Json needs more memory than the limit of " +
+                      std::to_string(limits.maxAllocation) + " bytes");
     }
   }
-  return result;
+  return true;
+}
+
+bool JsonParser::fail(JsonError &error, JsonErrorKind kind, std::size_t offset,
+                      std::string message) {
+  error.kind = kind;
+  error.offset = offset;
+  error.message = std::move(message);
+  return false;
 }
 
-Json JsonParser::parse(std::size_t from, std::size_t to) const {
+void JsonError::locate(std::string_view text) {
+  line = 1;
+  std::size_t lineStart = 0;
+  auto end = (offset < text.size()) ? offset : text.size();
+  auto newline = (const char *)std::memchr(text.data(), '\n', end);
+  while (newline != nullptr) {
+    line++;
+    lineStart = (std::size_t)(newline - text.data()) + 1;
+    newline = (const char *)std::memchr(text.data() + lineStart, '\n',
+                                        end - lineStart);
+  }
+  column = offset - lineStart + 1;
+}
+
+Json JsonParser::parse(std::string_view val) {
   auto result = Json();
-  if (to == -1) {
-    to = toks.size();
-  }
-  for (std::size_t i = from + 1; i < to; i++) {
-    auto tok = toks.at(i);
-    switch (tok.type) {
-    case TokenType::False: {
-      throw Exception("false should not occur outside Json scope");
-      break;
-    }
-    case TokenType::True: {
-      throw Exception("true should not occur outside Json scope");
-      break;
+  auto error = JsonError();
+  if (!tryParse(val, result, error)) {
+    throw Exception(error.message);
+  }
+  return result;
+}
+
+bool JsonParser::tryParse(std::string_view val, Json &result,
+                          JsonError &error, const JsonLimits &limits) {
+  auto keys = KeyCache();
+  return tryParse(val, result, error, limits, keys);
+}
+
+bool JsonParser::tryParse(std::string_view val, Json &result,
+                          JsonError &error, const JsonLimits &limits,
+                          KeyCache &keys) {
+  auto parser = JsonParser(true, limits);
+  auto builder = TreeBuilder(true, keys);
+  if (!parser.run(val, builder)) {
+    error = std::move(parser.error);
+    error.locate(val);
+    return false;
+  }
+  result = std::move(builder.result);
+  return true;
+}
+
+JsonValue JsonParser::parseValue(std::string_view val) {
+  auto parser = JsonParser(false);
+  auto keys = KeyCache();
+  auto builder = TreeBuilder(false, keys);
+  if (!parser.run(val, builder)) {
+    throw Exception(parser.error.message);
+  }
+  return std::move(builder.root);
+}
+
+bool JsonParser::parseElements(std::string_view val,
+                               std::vector<JsonValue> &result,
+                               KeyCache &keys) {
+  // The parser starts inside a list, which is never closed
+  auto parser = JsonParser(false);
+  auto builder = TreeBuilder(false, keys);
+  parser.open.push_back(true);
+  parser.expect = Expect::value;
+  builder.startList();
+  auto tok = Token(TokenType::null);
+  auto index = Index(val);
+  while (lexNext(index, tok)) {
+    if (!parser.push(tok, builder) || parser.open.empty()) {
+      return false;
     }
-    case TokenType::curlyBraceOpen: {
-      auto bClose = getPairEnd(false, i, to);
-      if (bClose.has_value()) {
-        auto pairs = parsePairs(i, bClose.value());
-        for (auto &pair : pairs) {
-          result[pair.first] = pair.second;
-        }
-        i = bClose.value();
-      } else {
-        throw Exception("End for { could not be found");
+  }
+  if (index.error.has() || (parser.open.size() != 1) ||
+      (parser.expect != Expect::separator)) {
+    return false;
+  }
+  result = builder.takeList();
+  return true;
+}
+
+std::vector<JsonValue> JsonParser::parseList(std::string_view text,
+                                             unsigned workers) {
+  // Texts smaller than this are not worth the threads
+  constexpr std::size_t minParallelSize = 1 << 20;
+  if (workers == 0) {
+    workers = std::thread::hardware_concurrency();
+  }
+  auto serial = [&]() {
+    auto value = parseValue(text);
+    if (!value.isList()) {
+      throw Exception("The top level value is not a list");
+    }
+    return std::move(*value.unique<std::vector<JsonValue>>());
+  };
+  if ((workers < 2) || (text.size() < minParallelSize)) {
+    return serial();
+  }
+
+  // Find the commas between elements of the top level list, and cut the list
+  // into chunks of roughly equal size at some of them. A few chunks per
+  // worker keeps the load balanced when elements differ in size
+  const std::size_t chunkSize = text.size() / (4 * (std::size_t)workers);
+  std::vector<std::string_view> chunks;
+  auto index = Index(text);
+  std::size_t depth = 0;
+  std::size_t start = 0;
+  std::size_t pos = 0;
+  bool closed = false;
+  while (!closed && index.next(pos)) {
+    switch (text[pos]) {
+    case '"': {
+      // Nothing inside a string is indexed, so skip its closing quote
+      if (!index.next(pos)) {
+        return serial();
       }
       break;
     }
-    case TokenType::curlyBraceClose: {
-      break;
-    }
-    case TokenType::string: {
-      throw Exception("String should not occur outside Json scope");
-      break;
-    }
-    case TokenType::integer: {
-      throw Exception("Integer should not occur outside Json scope");
-      break;
-    }
-    case TokenType::floating: {
-      throw Exception("Float number should not occur outside Json scope");
-      break;
-    }
-    case TokenType::comma: {
-      throw Exception("Comma should not occur outside Json scope");
-      break;
-    }
-    case TokenType::colon: {
-      throw Exception("Colon should not occur outside Json scope");
+    case '[':
+    case '{': {
+      if ((depth == 0) && (text[pos] == '{')) {
+        return serial();
+      }
+      if (depth++ == 0) {
+        start = pos + 1;
+      }
       break;
     }
-    case TokenType::null: {
-      throw Exception("Null should not occur outside Json scope");
+    case ']':
+    case '}': {
+      if (depth == 0) {
+        return serial();
+      }
+      if (--depth == 0) {
+        chunks.push_back(text.substr(start, pos - start));
+        closed = true;
+      }
       break;
     }
-    case TokenType::bracketOpen: {
-      throw Exception("List should not begin outside Json scope");
+    case ',': {
+      if ((depth == 1) && ((pos - start) >= chunkSize)) {
+        chunks.push_back(text.substr(start, pos - start));
+        start = pos + 1;
+      }
       break;
     }
-    case TokenType::bracketClose: {
-      throw Exception("] should not occur outside Json scope");
-      break;
+    default: {
+      if (depth == 0) {
+        return serial();
+      }
     }
     }
   }
+  // Anything unexpected is left to the serial parser, which reports it the
+  // same way as any other parse
+  if (!closed || index.next(pos) || (chunks.size() < 2)) {
+    return serial();
+  }
 
+  std::vector<std::vector<JsonValue>> parts(chunks.size());
+  std::atomic<std::size_t> nextChunk(0);
+  std::atomic<bool> failed(false);
+  // Keys are interned in the table of the calling thread
+  auto &table = JsonKeyTable::current();
+  auto work = [&]() {
+    auto scope = JsonKeyTable::Scope(table);
+    auto keys = KeyCache();
+    try {
+      for (auto i = nextChunk++; (i < chunks.size()) && !failed;
+           i = nextChunk++) {
+        if (!parseElements(chunks[i], parts[i], keys)) {
+          failed = true;
+        }
+      }
+    } catch (...) {
+      // Only allocation can throw here
+      failed = true;
+    }
+  };
+  std::vector<std::thread> threads;
+  auto count = std::min<std::size_t>(workers, chunks.size());
+  for (std::size_t i = 1; i < count; i++) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  if (failed) {
+    return serial();
+  }
+
+  std::size_t total = 0;
+  for (auto &part : parts) {
+    total += part.size();
+  }
+  std::vector<JsonValue> result;
+  result.reserve(total);
+  for (auto &part : parts) {
+    for (auto &value : part) {
+      result.push_back(std::move(value));
+    }
+    part.clear();
+  }
   return result;
 }
 
-} // namespace nuo
\ No newline at end of file
+std::size_t JsonParser::Tape::size() const { return types.size(); }
+
+std::size_t JsonParser::Tape::skip(std::size_t token) const {
+  return matches[token] > token ? matches[token] + 1 : token + 1;
+}
+
+std::string_view JsonParser::Tape::source(std::string_view text,
+                                          std::size_t token) const {
+  auto last = (matches[token] > token) ? matches[token] : token;
+  return text.substr(offsets[token], offsets[last] + lengths[last] -
+                                         offsets[token]);
+}
+
+JsonParser::Tape JsonParser::lex(std::string_view text) {
+  return lex(text, false);
+}
+
+JsonParser::Tape JsonParser::lex(std::string_view text, bool objectRoot) {
+  if (text.size() > UINT32_MAX) {
+    throw Exception("Text is too large for a token tape");
+  }
+  auto parser = JsonParser(objectRoot);
+  auto validator = Validator();
+  auto tok = Token(TokenType::null);
+  auto index = Index(text);
+  auto tape = Tape();
+  // Indices of the open objects and lists
+  std::vector<uint32_t> open;
+  while (lexNext(index, tok)) {
+    if (!parser.push(tok, validator)) {
+      throw Exception(parser.error.message);
+    }
+    auto current = (uint32_t)tape.types.size();
+    auto match = current;
+    if ((tok.type == TokenType::curlyBraceOpen) ||
+        (tok.type == TokenType::bracketOpen)) {
+      open.push_back(current);
+    } else if ((tok.type == TokenType::curlyBraceClose) ||
+               (tok.type == TokenType::bracketClose)) {
+      // A } outside any object is ignored by the grammar at the top level
+      if (open.empty()) {
+        continue;
+      }
+      match = open.back();
+      tape.matches[match] = current;
+      open.pop_back();
+    }
+    tape.types.push_back(tok.type);
+    tape.offsets.push_back((uint32_t)tok.offset);
+    tape.lengths.push_back((uint32_t)tok.length);
+    tape.matches.push_back(match);
+  }
+  if (index.error.has()) {
+    throw Exception(index.error.message);
+  }
+  if (!parser.finish(text.size())) {
+    throw Exception(parser.error.message);
+  }
+  return tape;
+}
+
+} // namespace nuo
@@ -0,0 +1,590 @@
+#include "nuo/json_patch.hpp"
+#include "nuo/exception.hpp"
+#include "nuo/json_binding.hpp"
+#include "nuo/json_parser.hpp"
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace nuo {
+
+namespace {
+
+const char *const typeNames[] = {"add",  "remove", "replace",
+                                 "move", "copy",   "test"};
+
+// Whether the first tokens of `pointer` are the tokens of `prefix`
+bool startsWith(const JsonPointer &pointer, const JsonPointer &prefix) {
+  if (prefix.size() > pointer.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < prefix.size(); i++) {
+    if (prefix.at(i) != pointer.at(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+// A change made to the document, recorded so that it can be undone. The
+// changed value is the last token of the pointer, inside the container that
+// the other tokens point to
+class JsonPatch::Change {
+public:
+  enum class Kind {
+    // Put `value` back at `position`
+    restore,
+    // Insert `value` at `position`
+    insert,
+    // Remove the value at `position`
+    erase,
+    // Put `value` back as the whole document
+    document,
+  };
+
+  Change(Kind _kind, const JsonPointer *_pointer, std::size_t _position,
+         JsonValue &&_value)
+      : kind(_kind), pointer(_pointer), position(_position),
+        value(std::move(_value)) {}
+
+  Kind kind;
+  const JsonPointer *pointer;
+  std::size_t position;
+  JsonValue value;
+};
+
+// Applies operations to a document and keeps the changes that were made, so
+// that they can be undone if a later operation fails
+class JsonPatch::Editor {
+private:
+  Json &document;
+
+  std::vector<Change> changes;
+
+  // Index of the operation being applied, used in error messages
+  std::size_t current;
+
+  [[noreturn]] void fail(const std::string &message) const {
+    throw Exception("JSON Patch operation " + std::to_string(current) +
+                    " failed: " + message);
+  }
+
+  // Position of the key in the object, including keys that have a none value
+  static bool position(const Json &object, const std::string &key,
+                       std::size_t &result) {
+    auto found = object.position(key);
+    if (found == object.keys.size()) {
+      return false;
+    }
+    result = found;
+    return true;
+  }
+
+  // Find the container that the first `count` tokens point to. Exactly one
+  // of `object` and `list` is set if it exists
+  bool container(const JsonPointer &pointer, std::size_t count, Json *&object,
+                 std::vector<JsonValue> *&list) const {
+    object = &document;
+    list = nullptr;
+    for (std::size_t i = 0; i < count; i++) {
+      auto value = child(object, list, pointer.at(i));
+      if (value == nullptr) {
+        return false;
+      }
+      object = nullptr;
+      list = nullptr;
+      if (value->type == JsonValueType::json) {
+        object = value->unique<Json>();
+      } else if (value->type == JsonValueType::list) {
+        list = value->unique<std::vector<JsonValue>>();
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // The value for the token in the object or list, which is const if they
+  // are
+  template <typename Object, typename List>
+  static auto child(Object *object, List *list, const std::string &token)
+      -> decltype(&(*list)[0]) {
+    std::size_t index = 0;
+    if (object != nullptr) {
+      if (position(*object, token, index) &&
+          (object->values[index].type != JsonValueType::none)) {
+        return &object->values[index];
+      }
+    } else if (JsonPointer::isIndex(token, index) && (index < list->size())) {
+      return &(*list)[index];
+    }
+    return nullptr;
+  }
+
+  // The value that a non empty pointer points to, or null if it does not
+  // exist, to be changed. Values that are shared on the way to it are copied
+  JsonValue *find(const JsonPointer &pointer) const {
+    Json *object = nullptr;
+    std::vector<JsonValue> *list = nullptr;
+    if (!container(pointer, pointer.size() - 1, object, list)) {
+      return nullptr;
+    }
+    return child(object, list, pointer.at(pointer.size() - 1));
+  }
+
+  // The value that a non empty pointer points to, or null if it does not
+  // exist, to be read. Unlike find, nothing that is shared on the way to it
+  // is copied
+  const JsonValue *read(const JsonPointer &pointer) const {
+    const Json *object = &document;
+    const std::vector<JsonValue> *list = nullptr;
+    for (std::size_t i = 0; i + 1 < pointer.size(); i++) {
+      auto value = child(object, list, pointer.at(i));
+      if (value == nullptr) {
+        return nullptr;
+      }
+      object = nullptr;
+      list = nullptr;
+      if (value->type == JsonValueType::json) {
+        object = value->heap<Json>();
+      } else if (value->type == JsonValueType::list) {
+        list = value->heap<std::vector<JsonValue>>();
+      } else {
+        return nullptr;
+      }
+    }
+    return child(object, list, pointer.at(pointer.size() - 1));
+  }
+
+  // The container of the value that a non empty pointer points to
+  void parent(const JsonPointer &pointer, Json *&object,
+              std::vector<JsonValue> *&list) const {
+    if (!container(pointer, pointer.size() - 1, object, list)) {
+      fail("The parent of " + pointer.toString() + " does not exist");
+    }
+  }
+
+  void replaceDocument(JsonValue &&value) {
+    if (value.type != JsonValueType::json) {
+      fail("The whole document can only be replaced with a Json object");
+    }
+    changes.emplace_back(Change::Kind::document, nullptr, 0,
+                         JsonValue(std::move(document)));
+    document = std::move(*value.unique<Json>());
+  }
+
+public:
+  Editor(Json &_document) : document(_document), changes(), current(0) {}
+
+  void setCurrent(std::size_t index) { current = index; }
+
+  void add(const JsonPointer &path, JsonValue &&value) {
+    if (path.size() == 0) {
+      return replaceDocument(std::move(value));
+    }
+    Json *object = nullptr;
+    std::vector<JsonValue> *list = nullptr;
+    parent(path, object, list);
+    auto &token = path.at(path.size() - 1);
+    std::size_t index = 0;
+    if (object != nullptr) {
+      if (position(*object, token, index)) {
+        auto old = std::move(object->values[index]);
+        object->values[index] = std::move(value);
+        changes.emplace_back(Change::Kind::restore, &path, index,
+                             std::move(old));
+      } else {
+        object->append(JsonKey(token), std::move(value));
+        changes.emplace_back(Change::Kind::erase, &path,
+                             object->keys.size() - 1, JsonValue::none());
+      }
+      return;
+    }
+    if (token == "-") {
+      index = list->size();
+    } else if (!JsonPointer::isIndex(token, index) || (index > list->size())) {
+      fail("The index of " + path.toString() + " is out of range");
+    }
+    list->insert(list->begin() + index, std::move(value));
+    changes.emplace_back(Change::Kind::erase, &path, index, JsonValue::none());
+  }
+
+  // Remove the value. If `keep` is true, the value is returned, and the caller
+  // puts it in the change if the operation fails. Otherwise the change keeps
+  // it for undoing, and none is returned
+  JsonValue remove(const JsonPointer &path, bool keep) {
+    if (path.size() == 0) {
+      fail("The whole document cannot be removed");
+    }
+    Json *object = nullptr;
+    std::vector<JsonValue> *list = nullptr;
+    auto &token = path.at(path.size() - 1);
+    std::size_t index = 0;
+    JsonValue removed;
+    if (!container(path, path.size() - 1, object, list) ||
+        (child(object, list, token) == nullptr)) {
+      fail("The path " + path.toString() + " does not exist");
+    }
+    if (object != nullptr) {
+      position(*object, token, index);
+      removed = std::move(object->values[index]);
+      object->remove(index);
+    } else {
+      JsonPointer::isIndex(token, index);
+      removed = std::move((*list)[index]);
+      list->erase(list->begin() + index);
+    }
+    if (keep) {
+      changes.emplace_back(Change::Kind::insert, &path, index,
+                           JsonValue::none());
+      return removed;
+    }
+    changes.emplace_back(Change::Kind::insert, &path, index,
+                         std::move(removed));
+    return JsonValue::none();
+  }
+
+  void replace(const JsonPointer &path, JsonValue &&value) {
+    if (path.size() == 0) {
+      return replaceDocument(std::move(value));
+    }
+    auto target = find(path);
+    if (target == nullptr) {
+      fail("The path " + path.toString() + " does not exist");
+    }
+    Json *object = nullptr;
+    std::vector<JsonValue> *list = nullptr;
+    container(path, path.size() - 1, object, list);
+    std::size_t index = 0;
+    if (object != nullptr) {
+      position(*object, path.at(path.size() - 1), index);
+    } else {
+      JsonPointer::isIndex(path.at(path.size() - 1), index);
+    }
+    auto old = std::move(*target);
+    *target = std::move(value);
+    changes.emplace_back(Change::Kind::restore, &path, index, std::move(old));
+  }
+
+  void move(const JsonPointer &from, const JsonPointer &path) {
+    if (startsWith(path, from)) {
+      if (path.size() != from.size()) {
+        fail("A value cannot be moved into itself");
+      }
+      if ((from.size() != 0) && (read(from) == nullptr)) {
+        fail("The path " + from.toString() + " does not exist");
+      }
+      return;
+    }
+    auto value = remove(from, true);
+    try {
+      add(path, std::move(value));
+    } catch (...) {
+      // The value was not added, so it goes back where it was removed from
+      changes.back().value = std::move(value);
+      throw;
+    }
+  }
+
+  void copy(const JsonPointer &from, const JsonPointer &path) {
+    if (from.size() == 0) {
+      return add(path, JsonValue(document));
+    }
+    auto source = read(from);
+    if (source == nullptr) {
+      fail("The path " + from.toString() + " does not exist");
+    }
+    add(path, JsonValue(*source));
+  }
+
+  void test(const JsonPointer &path, const JsonValue &value) {
+    bool passed = false;
+    if (path.size() == 0) {
+      passed = (value.type == JsonValueType::json) &&
+               equal(document, *value.heap<Json>());
+    } else {
+      auto target = read(path);
+      passed = (target != nullptr) && equal(*target, value);
+    }
+    if (!passed) {
+      fail("The value at " + path.toString() + " is not the tested value");
+    }
+  }
+
+  // Undo every change in reverse order. Values that are taken out of the
+  // document by undoing an insertion are carried to the change before it,
+  // which is where a moved value came from
+  void undo() {
+    JsonValue carried;
+    for (auto change = changes.rbegin(); change != changes.rend(); change++) {
+      if (change->kind == Change::Kind::document) {
+        carried = JsonValue(std::move(document));
+        document = std::move(*change->value.unique<Json>());
+        continue;
+      }
+      Json *object = nullptr;
+      std::vector<JsonValue> *list = nullptr;
+      auto &pointer = *change->pointer;
+      container(pointer, pointer.size() - 1, object, list);
+      auto &values = (object != nullptr) ? object->values : *list;
+      auto index = change->position;
+      switch (change->kind) {
+      case Change::Kind::restore: {
+        carried = std::move(values[index]);
+        values[index] = std::move(change->value);
+        break;
+      }
+      case Change::Kind::erase: {
+        carried = std::move(values[index]);
+        if (object != nullptr) {
+          object->remove(index);
+        } else {
+          values.erase(values.begin() + index);
+        }
+        break;
+      }
+      case Change::Kind::insert: {
+        auto &value = change->value.isNone() ? carried : change->value;
+        if (object != nullptr) {
+          object->insert(index, JsonKey(pointer.at(pointer.size() - 1)),
+                         std::move(value));
+        } else {
+          values.insert(values.begin() + index, std::move(value));
+        }
+        break;
+      }
+      case Change::Kind::document: {
+        break;
+      }
+      }
+    }
+    changes.clear();
+  }
+
+  // Equality as defined by JSON Patch, where numbers are compared by value
+  // and the members of objects can be in any order
+  static bool equal(const JsonValue &first, const JsonValue &second) {
+    auto number = [](const JsonValue &value) {
+      return value.isInt() ? (double)value.asInt() : value.asDouble();
+    };
+    bool mixed = (first.isInt() && second.isDouble()) ||
+                 (first.isDouble() && second.isInt());
+    if (mixed) {
+      return number(first) == number(second);
+    }
+    if (first.type != second.type) {
+      return false;
+    }
+    switch (first.type) {
+    case JsonValueType::json: {
+      return equal(*first.heap<Json>(), *second.heap<Json>());
+    }
+    case JsonValueType::list: {
+      auto &firstList = *first.heap<std::vector<JsonValue>>();
+      auto &secondList = *second.heap<std::vector<JsonValue>>();
+      if (firstList.size() != secondList.size()) {
+        return false;
+      }
+      for (std::size_t i = 0; i < firstList.size(); i++) {
+        if (!equal(firstList[i], secondList[i])) {
+          return false;
+        }
+      }
+      return true;
+    }
+    default: {
+      return first == second;
+    }
+    }
+  }
+
+  static bool equal(const Json &first, const Json &second) {
+    if (first.size() != second.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < first.keys.size(); i++) {
+      if (first.values[i].type == JsonValueType::none) {
+        continue;
+      }
+      std::size_t index = 0;
+      if (!position(second, first.keys[i].text(), index) ||
+          !equal(first.values[i], second.values[index])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Take the members of a Json object that describes an operation
+  static Operation take(JsonValue &value, std::size_t index) {
+    auto invalid = [&](const std::string &message) {
+      return Exception("JSON Patch operation " + std::to_string(index) +
+                       " is not valid: " + message);
+    };
+    if (value.type != JsonValueType::json) {
+      throw invalid("It is not an object");
+    }
+    auto &object = *value.unique<Json>();
+    auto member = [&](const std::string &key) -> JsonValue * {
+      std::size_t position = 0;
+      if (Editor::position(object, key, position) &&
+          (object.values[position].type != JsonValueType::none)) {
+        return &object.values[position];
+      }
+      return nullptr;
+    };
+    auto pointer = [&](const std::string &key) {
+      auto text = member(key);
+      if ((text == nullptr) || (text->type != JsonValueType::string)) {
+        throw invalid("\"" + key + "\" should be a string");
+      }
+      try {
+        return JsonPointer(text->view());
+      } catch (Exception &err) {
+        throw invalid(err.what());
+      }
+    };
+    auto op = member("op");
+    if ((op == nullptr) || (op->type != JsonValueType::string)) {
+      throw invalid("\"op\" should be a string");
+    }
+    auto name = op->view();
+    for (std::size_t i = 0; i < 6; i++) {
+      if (name != typeNames[i]) {
+        continue;
+      }
+      auto type = (OperationType)i;
+      auto path = pointer("path");
+      if ((type == OperationType::move) || (type == OperationType::copy)) {
+        return Operation(type, std::move(path), pointer("from"),
+                         JsonValue::none());
+      }
+      if (type == OperationType::remove) {
+        return Operation(type, std::move(path), JsonPointer(""),
+                         JsonValue::none());
+      }
+      auto content = member("value");
+      if (content == nullptr) {
+        throw invalid("\"value\" is required for " + std::string(name));
+      }
+      return Operation(type, std::move(path), JsonPointer(""),
+                       std::move(*content));
+    }
+    throw invalid("Unknown operation " + std::string(name));
+  }
+};
+
+JsonPatch::Operation::Operation(OperationType _type, JsonPointer _path,
+                                JsonPointer _from, JsonValue _value)
+    : type(_type), path(std::move(_path)), from(std::move(_from)),
+      value(std::move(_value)) {}
+
+JsonPatch::JsonPatch(std::string_view text)
+    : JsonPatch(JsonValue(JsonParser::parseList(text, 1))) {}
+
+JsonPatch::JsonPatch(JsonValue &&patch) : ops() {
+  if (patch.type != JsonValueType::list) {
+    throw Exception("A JSON Patch should be a list of operations");
+  }
+  auto &list = *patch.unique<std::vector<JsonValue>>();
+  ops.reserve(list.size());
+  for (std::size_t i = 0; i < list.size(); i++) {
+    ops.push_back(Editor::take(list[i], i));
+  }
+}
+
+JsonPatch::JsonPatch(std::vector<Operation> &&operations)
+    : ops(std::move(operations)) {}
+
+const std::vector<JsonPatch::Operation> &JsonPatch::operations() const {
+  return ops;
+}
+
+JsonValue JsonPatch::toJsonValue() const {
+  std::vector<JsonValue> list;
+  list.reserve(ops.size());
+  for (auto &op : ops) {
+    auto object = Json()
+                      ._("op", typeNames[(std::size_t)op.type])
+                      ._("path", op.path.toString());
+    if ((op.type == OperationType::move) || (op.type == OperationType::copy)) {
+      object._("from", op.from.toString());
+    } else if (op.type != OperationType::remove) {
+      object._("value", op.value);
+    }
+    list.push_back(JsonValue(std::move(object)));
+  }
+  return JsonValue(std::move(list));
+}
+
+std::string JsonPatch::toString() const {
+  auto writer = JsonWriter();
+  writer.value(toJsonValue());
+  return std::move(writer.result);
+}
+
+namespace {
+
+// Apply the operations, copying their values if they are const and moving
+// them otherwise
+template <typename Editor, typename Operations>
+void applyAll(Editor &editor, Operations &ops) {
+  try {
+    for (std::size_t i = 0; i < ops.size(); i++) {
+      auto &op = ops[i];
+      editor.setCurrent(i);
+      auto value = [&]() {
+        if constexpr (std::is_const_v<Operations>) {
+          return JsonValue(op.value);
+        } else {
+          return std::move(op.value);
+        }
+      };
+      switch (op.type) {
+      case JsonPatch::OperationType::add: {
+        editor.add(op.path, value());
+        break;
+      }
+      case JsonPatch::OperationType::remove: {
+        editor.remove(op.path, false);
+        break;
+      }
+      case JsonPatch::OperationType::replace: {
+        editor.replace(op.path, value());
+        break;
+      }
+      case JsonPatch::OperationType::move: {
+        editor.move(op.from, op.path);
+        break;
+      }
+      case JsonPatch::OperationType::copy: {
+        editor.copy(op.from, op.path);
+        break;
+      }
+      case JsonPatch::OperationType::test: {
+        editor.test(op.path, op.value);
+        break;
+      }
+      }
+    }
+  } catch (...) {
+    editor.undo();
+    throw;
+  }
+}
+
+} // namespace
+
+void JsonPatch::apply(Json &document) const & {
+  auto editor = Editor(document);
+  applyAll(editor, ops);
+}
+
+void JsonPatch::apply(Json &document) && {
+  auto editor = Editor(document);
+  applyAll(editor, ops);
+}
+
+} // namespace nuo
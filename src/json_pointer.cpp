@@ -0,0 +1,207 @@
+#include "nuo/json_pointer.hpp"
+#include "nuo/exception.hpp"
+#include "nuo/json_parser.hpp"
+#include <utility>
+
+namespace nuo {
+
+JsonPointer::JsonPointer(std::string_view pointer) : tokens() {
+  if (pointer.empty()) {
+    return;
+  }
+  if (pointer[0] != '/') {
+    throw Exception("Json pointer should begin with /");
+  }
+  for (std::size_t i = 1; i <= pointer.size(); i++) {
+    tokens.emplace_back();
+    auto &token = tokens.back();
+    for (; (i < pointer.size()) && (pointer[i] != '/'); i++) {
+      if (pointer[i] != '~') {
+        token += pointer[i];
+      } else if ((i + 1 < pointer.size()) &&
+                 ((pointer[i + 1] == '0') || (pointer[i + 1] == '1'))) {
+        token += (pointer[++i] == '0') ? '~' : '/';
+      } else {
+        throw Exception("Invalid escape sequence found in Json pointer");
+      }
+    }
+  }
+}
+
+JsonPointer::JsonPointer(std::vector<std::string> _tokens)
+    : tokens(std::move(_tokens)) {}
+
+std::size_t JsonPointer::size() const { return tokens.size(); }
+
+const std::string &JsonPointer::at(std::size_t index) const {
+  return tokens.at(index);
+}
+
+std::string JsonPointer::toString() const {
+  std::string result;
+  for (auto &token : tokens) {
+    result += '/';
+    for (auto chr : token) {
+      if (chr == '~') {
+        result += "~0";
+      } else if (chr == '/') {
+        result += "~1";
+      } else {
+        result += chr;
+      }
+    }
+  }
+  return result;
+}
+
+bool JsonPointer::isIndex(std::string_view token, std::size_t &index) {
+  if (token.empty() || (token.size() > 18) ||
+      ((token[0] == '0') && (token.size() > 1))) {
+    return false;
+  }
+  std::size_t result = 0;
+  for (auto chr : token) {
+    if ((chr < '0') || (chr > '9')) {
+      return false;
+    }
+    result = (result * 10) + (std::size_t)(chr - '0');
+  }
+  index = result;
+  return true;
+}
+
+Maybe<std::string_view> JsonPointer::find(std::string_view text) const {
+  using TokenType = JsonParser::TokenType;
+  auto index = JsonParser::Index(text);
+  auto tok = JsonParser::Token(TokenType::null);
+  auto invalid = [&]() {
+    if (index.error.has()) {
+      return Exception(index.error.message);
+    }
+    return Exception("Invalid Json found at " + std::to_string(tok.offset) +
+                     " while evaluating the pointer " + toString());
+  };
+  // Lex the next token, which has to exist
+  auto expectToken = [&]() {
+    if (!JsonParser::lexNext(index, tok)) {
+      throw invalid();
+    }
+  };
+  // Skip the value beginning at `tok`, and get the position after it. Nested
+  // values are skipped by counting brackets in the structural index, since
+  // nothing inside strings is indexed except the closing quotes
+  auto skipValue = [&]() {
+    if ((tok.type != TokenType::curlyBraceOpen) &&
+        (tok.type != TokenType::bracketOpen)) {
+      return tok.offset + tok.length;
+    }
+    std::size_t depth = 1;
+    std::size_t pos = 0;
+    while (index.next(pos)) {
+      switch (text[pos]) {
+      case '"': {
+        if (!index.next(pos)) {
+          throw Exception("End for \" could not be found");
+        }
+        break;
+      }
+      case '{':
+      case '[': {
+        depth++;
+        break;
+      }
+      case '}':
+      case ']': {
+        if (--depth == 0) {
+          return pos + 1;
+        }
+        break;
+      }
+      default: {
+        break;
+      }
+      }
+    }
+    throw Exception(std::string("End for ") +
+                    ((tok.type == TokenType::bracketOpen) ? "[" : "{") +
+                    " could not be found");
+  };
+
+  if (!JsonParser::lexNext(index, tok)) {
+    if (index.error.has()) {
+      throw invalid();
+    }
+    return Maybe<std::string_view>();
+  }
+  for (auto &token : tokens) {
+    if (tok.type == TokenType::curlyBraceOpen) {
+      // The last member with the key is its value, like when parsing a Json,
+      // so the whole object is read. The value of the last match is lexed
+      // again from its offset after the object
+      std::size_t match = -1;
+      expectToken();
+      while (tok.type != TokenType::curlyBraceClose) {
+        if (tok.type != TokenType::string) {
+          throw invalid();
+        }
+        bool found = (tok.view == token);
+        expectToken();
+        if (tok.type != TokenType::colon) {
+          throw invalid();
+        }
+        expectToken();
+        if (found) {
+          match = tok.offset;
+        }
+        skipValue();
+        expectToken();
+        if (tok.type == TokenType::comma) {
+          expectToken();
+        } else if (tok.type != TokenType::curlyBraceClose) {
+          throw invalid();
+        }
+      }
+      if (match == (std::size_t)-1) {
+        return Maybe<std::string_view>();
+      }
+      index.seek(match);
+      expectToken();
+    } else if (tok.type == TokenType::bracketOpen) {
+      std::size_t target = 0;
+      if (!isIndex(token, target)) {
+        return Maybe<std::string_view>();
+      }
+      expectToken();
+      for (std::size_t i = 0; i < target; i++) {
+        if (tok.type == TokenType::bracketClose) {
+          return Maybe<std::string_view>();
+        }
+        skipValue();
+        expectToken();
+        if (tok.type == TokenType::comma) {
+          expectToken();
+        } else if (tok.type != TokenType::bracketClose) {
+          throw invalid();
+        }
+      }
+      if (tok.type == TokenType::bracketClose) {
+        return Maybe<std::string_view>();
+      }
+    } else {
+      return Maybe<std::string_view>();
+    }
+  }
+  auto start = tok.offset;
+  auto end = skipValue();
+  return Maybe<std::string_view>(text.substr(start, end - start));
+}
+
+JsonValue JsonPointer::get(std::string_view text) const {
+  auto value = find(text);
+  if (!value.has()) {
+    return JsonValue::none();
+  }
+  return JsonParser::parseValue(value.get());
+}
+
+} // namespace nuo
@@ -0,0 +1,202 @@
+#include "nuo/json_reader.hpp"
+
+namespace nuo {
+
+JsonReader::JsonReader(const JsonLimits &limits)
+    : parser(false, limits), tok(JsonParser::TokenType::null), index(""),
+      queue(), frames(), pending(), partial(Partial::none), isEscape(false),
+      fed(0), consumed(0) {}
+
+void JsonReader::feed(std::string_view chunk) {
+  const std::string_view digits = "0123456789";
+  const std::string_view alpha = "truefalsn";
+  auto &limits = parser.limits;
+  fed += chunk.size();
+  if ((limits.maxBytes != 0) && (fed > limits.maxBytes)) {
+    throw Exception("Json text is larger than the limit of " +
+                    std::to_string(limits.maxBytes) + " bytes");
+  }
+  // Only the ends of tokens are found here. The tokens up to the last end
+  // are indexed and lexed in one pass afterwards
+  std::size_t ready = 0;
+  std::size_t i = 0;
+  while (i < chunk.size()) {
+    switch (partial) {
+    case Partial::string: {
+      for (; i < chunk.size(); i++) {
+        if (isEscape) {
+          isEscape = false;
+        } else if (chunk[i] == '\\') {
+          isEscape = true;
+        } else if (chunk[i] == '"') {
+          break;
+        }
+      }
+      if (i < chunk.size()) {
+        i++;
+        partial = Partial::none;
+        ready = i;
+      }
+      break;
+    }
+    case Partial::number:
+    case Partial::literal: {
+      for (; i < chunk.size(); i++) {
+        auto chr = chunk[i];
+        if (partial == Partial::number
+                ? ((digits.find(chr) == std::string_view::npos) &&
+                   (chr != '.') && (chr != '-') && (chr != '+') &&
+                   (chr != 'e') && (chr != 'E'))
+                : (alpha.find(chr) == std::string_view::npos)) {
+          break;
+        }
+      }
+      if (i < chunk.size()) {
+        partial = Partial::none;
+        ready = i;
+      }
+      break;
+    }
+    case Partial::none: {
+      auto chr = chunk[i];
+      if (chr == '"') {
+        partial = Partial::string;
+        isEscape = false;
+        i++;
+      } else if ((digits.find(chr) != std::string_view::npos) ||
+                 (chr == '-')) {
+        partial = Partial::number;
+      } else if (alpha.find(chr) != std::string_view::npos) {
+        partial = Partial::literal;
+      } else {
+        i++;
+        ready = i;
+      }
+      break;
+    }
+    }
+  }
+  if (ready > 0) {
+    if (pending.empty()) {
+      lex(chunk.substr(0, ready));
+    } else {
+      pending.append(chunk.substr(0, ready));
+      lex(pending);
+      pending.clear();
+    }
+  }
+  pending.append(chunk.substr(ready));
+  // An escape sequence has at most 6 bytes and decodes to at least 1
+  if ((partial == Partial::string) && (limits.maxStringLength != 0) &&
+      (pending.size() > (6 * limits.maxStringLength) + 2)) {
+    throw Exception("String is longer than the limit of " +
+                    std::to_string(limits.maxStringLength) + " bytes");
+  }
+}
+
+void JsonReader::lex(std::string_view text) {
+  index.reset(text);
+  while (JsonParser::lexNext(index, tok)) {
+    if (!parser.push(tok, queue)) {
+      raise(parser.error);
+    }
+  }
+  if (index.error.has()) {
+    raise(index.error);
+  }
+  consumed += text.size();
+}
+
+void JsonReader::raise(JsonError error) const {
+  // Positions are found in the text being lexed, which begins after the
+  // bytes that were consumed before it
+  auto relative = " at " + std::to_string(error.offset);
+  auto absolute = " at " + std::to_string(consumed + error.offset);
+  auto &message = error.message;
+  if (message.ends_with(relative)) {
+    message.replace(message.size() - relative.size(), relative.size(),
+                    absolute);
+  } else {
+    message += absolute;
+  }
+  throw Exception(message);
+}
+
+void JsonReader::finish() {
+  if (!pending.empty()) {
+    lex(pending);
+    pending.clear();
+    partial = Partial::none;
+  }
+  if (!parser.finish(0)) {
+    raise(parser.error);
+  }
+}
+
+bool JsonReader::next(Event &event) {
+  if (queue.events.empty()) {
+    return false;
+  }
+  event = std::move(queue.events.front());
+  queue.events.pop_front();
+  return true;
+}
+
+bool JsonReader::assemble(JsonValue &&value, JsonValue &result) {
+  if (frames.empty()) {
+    result = std::move(value);
+    return true;
+  }
+  auto &parent = frames.back();
+  if (parent.isList) {
+    parent.list.push_back(std::move(value));
+  } else {
+    parent.object[parent.key] = std::move(value);
+  }
+  return false;
+}
+
+bool JsonReader::nextValue(JsonValue &value) {
+  auto event = Event();
+  while (next(event)) {
+    switch (event.type) {
+    case EventType::startObject: {
+      frames.push_back(Frame(false));
+      break;
+    }
+    case EventType::startList: {
+      frames.push_back(Frame(true));
+      break;
+    }
+    case EventType::key: {
+      frames.back().key = std::move(event.key);
+      break;
+    }
+    case EventType::endObject: {
+      auto done = JsonValue(std::move(frames.back().object));
+      frames.pop_back();
+      if (assemble(std::move(done), value)) {
+        return true;
+      }
+      break;
+    }
+    case EventType::endList: {
+      auto done = JsonValue(std::move(frames.back().list));
+      frames.pop_back();
+      if (assemble(std::move(done), value)) {
+        return true;
+      }
+      break;
+    }
+    case EventType::value: {
+      if (assemble(std::move(event.value), value)) {
+        return true;
+      }
+      break;
+    }
+    }
+  }
+  return false;
+}
+
+} // namespace nuo
@@ -0,0 +1,104 @@
+#include "nuo/json_ref.hpp"
+
+namespace nuo {
+
+JsonRef::JsonRef(const JsonValue *_value)
+    : value(_value), object((_value != nullptr) && _value->isJson()
+                                ? &_value->viewJson()
+                                : nullptr) {}
+
+JsonRef::JsonRef(const Json &document) : value(nullptr), object(&document) {}
+
+JsonRef::JsonRef(const JsonValue &_value) : JsonRef(&_value) {}
+
+JsonValueType JsonRef::getType() const {
+  if (object != nullptr) {
+    return JsonValueType::json;
+  }
+  return (value != nullptr) ? value->getType() : JsonValueType::none;
+}
+
+bool JsonRef::isInt() const { return getType() == JsonValueType::integer; }
+
+int64_t JsonRef::asInt() const { return value->asInt(); }
+
+bool JsonRef::isDouble() const { return getType() == JsonValueType::decimal; }
+
+double JsonRef::asDouble() const { return value->asDouble(); }
+
+bool JsonRef::isNull() const { return getType() == JsonValueType::null; }
+
+bool JsonRef::isString() const { return getType() == JsonValueType::string; }
+
+std::string_view JsonRef::asString() const { return value->viewString(); }
+
+bool JsonRef::isBool() const { return getType() == JsonValueType::boolean; }
+
+bool JsonRef::asBool() const { return value->asBool(); }
+
+bool JsonRef::isJson() const { return object != nullptr; }
+
+const Json &JsonRef::asJson() const { return *object; }
+
+bool JsonRef::isList() const { return getType() == JsonValueType::list; }
+
+std::span<const JsonValue> JsonRef::asList() const {
+  return value->viewList();
+}
+
+bool JsonRef::isNone() const { return getType() == JsonValueType::none; }
+
+std::size_t JsonRef::size() const {
+  if (isJson()) {
+    return object->size();
+  }
+  return isList() ? value->viewList().size() : 0;
+}
+
+bool JsonRef::has(std::string_view key) const {
+  return !(*this)[key].isNone();
+}
+
+JsonRef JsonRef::operator[](std::string_view key) const {
+  if (isJson()) {
+    auto index = object->position(key);
+    if (index < object->keys.size()) {
+      return JsonRef(&object->values[index]);
+    }
+  }
+  return JsonRef(nullptr);
+}
+
+JsonRef JsonRef::at(std::size_t index) const {
+  if (isList()) {
+    auto list = value->viewList();
+    if (index < list.size()) {
+      return JsonRef(&list[index]);
+    }
+  }
+  return JsonRef(nullptr);
+}
+
+JsonRef JsonRef::at(const JsonPointer &pointer) const {
+  auto result = *this;
+  for (std::size_t i = 0; (i < pointer.size()) && !result.isNone(); i++) {
+    auto &token = pointer.at(i);
+    std::size_t index = 0;
+    if (result.isList()) {
+      result = JsonPointer::isIndex(token, index) ? result.at(index)
+                                                  : JsonRef(nullptr);
+    } else {
+      result = result[token];
+    }
+  }
+  return result;
+}
+
+JsonValue JsonRef::toJsonValue() const {
+  if ((value == nullptr) && (object != nullptr)) {
+    return JsonValue(*object);
+  }
+  return (value != nullptr) ? *value : JsonValue::none();
+}
+
+} // namespace nuo
@@ -0,0 +1,112 @@
+#include "nuo/lazy_json.hpp"
+#include "nuo/exception.hpp"
+
+namespace nuo {
+
+namespace {
+
+const JsonValue noneValue = JsonValue::none();
+
+} // namespace
+
+LazyJson::Source::Source(std::string _text)
+    : text(std::move(_text)), tape() {
+  tape = JsonParser::lex(text, true);
+  if (tape.size() == 0) {
+    throw Exception("No object found for the lazy Json");
+  }
+  if (tape.skip(0) != tape.size()) {
+    throw Exception("Only one object is allowed at the top level of a "
+                    "lazy Json");
+  }
+}
+
+bool LazyJson::Source::isKey(std::size_t token, std::string_view key) const {
+  auto raw = std::string_view(text).substr(tape.offsets[token] + 1,
+                                           tape.lengths[token] - 2);
+  if (raw.find('\\') == std::string_view::npos) {
+    return raw == key;
+  }
+  auto index = JsonParser::Index(tape.source(text, token));
+  auto tok = JsonParser::Token(JsonParser::TokenType::null);
+  JsonParser::lexNext(index, tok);
+  return tok.view == key;
+}
+
+LazyJson::LazyJson(std::string text)
+    : LazyJson(std::make_shared<const Source>(std::move(text)), 0) {}
+
+LazyJson::LazyJson(std::shared_ptr<const Source> _source, std::size_t start)
+    : source(std::move(_source)), members(), values() {
+  using TokenType = JsonParser::TokenType;
+  auto &tape = source->tape;
+  auto &types = tape.types;
+  // Each member is a key, a colon and a value, followed by a comma or the end
+  // of the object
+  auto token = start + 1;
+  while (types[token] != TokenType::curlyBraceClose) {
+    members.push_back((uint32_t)(token + 2));
+    token = tape.skip(token + 2);
+    if (types[token] == TokenType::comma) {
+      token++;
+    }
+  }
+  values.resize(members.size(), JsonValue::none());
+}
+
+std::size_t LazyJson::find(std::string_view key) const {
+  // The last occurence of a key is its value, like when parsing a Json
+  for (auto i = members.size(); i > 0; i--) {
+    if (source->isKey(members[i - 1] - 2, key)) {
+      return i - 1;
+    }
+  }
+  return -1;
+}
+
+bool LazyJson::has(std::string_view key) const {
+  return find(key) != (std::size_t)-1;
+}
+
+JsonValue LazyJson::parseMember(std::size_t pos) const {
+  return JsonParser::parseValue(
+      source->tape.source(source->text, members[pos]));
+}
+
+const JsonValue &LazyJson::operator[](std::string_view key) const {
+  auto pos = find(key);
+  if (pos == (std::size_t)-1) {
+    return noneValue;
+  }
+  if (values[pos].isNone()) {
+    values[pos] = parseMember(pos);
+  }
+  return values[pos];
+}
+
+LazyJson LazyJson::object(std::string_view key) const {
+  auto pos = find(key);
+  if ((pos == (std::size_t)-1) ||
+      (source->tape.types[members[pos]] !=
+       JsonParser::TokenType::curlyBraceOpen)) {
+    throw Exception("No object found for the key " + std::string(key));
+  }
+  return LazyJson(source, members[pos]);
+}
+
+std::size_t LazyJson::size() const { return members.size(); }
+
+Json LazyJson::toJson() const {
+  auto result = Json();
+  auto tok = JsonParser::Token(JsonParser::TokenType::null);
+  for (std::size_t i = 0; i < members.size(); i++) {
+    auto index =
+        JsonParser::Index(source->tape.source(source->text, members[i] - 2));
+    JsonParser::lexNext(index, tok);
+    result[std::string(tok.view)] =
+        values[i].isNone() ? parseMember(i) : values[i];
+  }
+  return result;
+}
+
+} // namespace nuo
@@ -0,0 +1,149 @@
+#include "nuo/mapped_file.hpp"
+#include "nuo/exception.hpp"
+
+#if PLATFORM_IS_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nuo {
+
+#if PLATFORM_IS_WINDOWS
+
+MappedFile::MappedFile()
+    : start(nullptr), len(0), file(nullptr), mapping(nullptr) {}
+
+MappedFile::MappedFile(const std::string &path)
+    : start(nullptr), len(0), file(nullptr), mapping(nullptr) {
+  file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                     OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    file = nullptr;
+    throw Exception("Could not open the file " + path);
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize)) {
+    clear();
+    throw Exception("Could not get the size of the file " + path);
+  }
+  len = (std::size_t)fileSize.QuadPart;
+  if (len == 0) {
+    return;
+  }
+  mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    clear();
+    throw Exception("Could not map the file " + path);
+  }
+  start = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (start == nullptr) {
+    clear();
+    throw Exception("Could not map the file " + path);
+  }
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : start(other.start), len(other.len), file(other.file),
+      mapping(other.mapping) {
+  other.start = nullptr;
+  other.len = 0;
+  other.file = nullptr;
+  other.mapping = nullptr;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  clear();
+  start = other.start;
+  len = other.len;
+  file = other.file;
+  mapping = other.mapping;
+  other.start = nullptr;
+  other.len = 0;
+  other.file = nullptr;
+  other.mapping = nullptr;
+  return *this;
+}
+
+void MappedFile::clear() noexcept {
+  if (start) {
+    UnmapViewOfFile(start);
+    start = nullptr;
+  }
+  if (mapping) {
+    CloseHandle(mapping);
+    mapping = nullptr;
+  }
+  if (file) {
+    CloseHandle(file);
+    file = nullptr;
+  }
+  len = 0;
+}
+
+#else
+
+MappedFile::MappedFile() : start(nullptr), len(0) {}
+
+MappedFile::MappedFile(const std::string &path) : start(nullptr), len(0) {
+  auto file = open(path.c_str(), O_RDONLY);
+  if (file == -1) {
+    throw Exception("Could not open the file " + path);
+  }
+  struct stat info;
+  if (fstat(file, &info) == -1) {
+    close(file);
+    throw Exception("Could not get the size of the file " + path);
+  }
+  len = (std::size_t)info.st_size;
+  if (len == 0) {
+    close(file);
+    return;
+  }
+  auto mapped = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+  if (mapped == MAP_FAILED) {
+    len = 0;
+    throw Exception("Could not map the file " + path);
+  }
+  madvise(mapped, len, MADV_SEQUENTIAL);
+  start = (const char *)mapped;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : start(other.start), len(other.len) {
+  other.start = nullptr;
+  other.len = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  clear();
+  start = other.start;
+  len = other.len;
+  other.start = nullptr;
+  other.len = 0;
+  return *this;
+}
+
+void MappedFile::clear() noexcept {
+  if (start) {
+    munmap((void *)start, len);
+    start = nullptr;
+  }
+  len = 0;
+}
+
+#endif
+
+std::string_view MappedFile::view() const noexcept {
+  return std::string_view(start, len);
+}
+
+std::size_t MappedFile::size() const noexcept { return len; }
+
+MappedFile::~MappedFile() noexcept { clear(); }
+
+} // namespace nuo
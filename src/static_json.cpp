@@ -0,0 +1,50 @@
+#include "nuo/static_json.hpp"
+#include "nuo/exception.hpp"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nuo {
+
+void staticJsonError(const char *message) { throw Exception(message); }
+
+JsonValue StaticJson::toJsonValue() const {
+  switch (getType()) {
+  case JsonValueType::integer: {
+    return JsonValue(asInt());
+  }
+  case JsonValueType::decimal: {
+    return JsonValue(asDouble());
+  }
+  case JsonValueType::string: {
+    return JsonValue(std::string(asString()));
+  }
+  case JsonValueType::boolean: {
+    return JsonValue(asBool());
+  }
+  case JsonValueType::null: {
+    return JsonValue();
+  }
+  case JsonValueType::json: {
+    auto result = Json();
+    for (std::size_t i = index + 1; i < node().end; i = nodes[i].end) {
+      auto value = StaticJson(nodes, chars, i);
+      result[std::string(value.key())] = value.toJsonValue();
+    }
+    return JsonValue(std::move(result));
+  }
+  case JsonValueType::list: {
+    std::vector<JsonValue> result;
+    for (std::size_t i = index + 1; i < node().end; i = nodes[i].end) {
+      result.push_back(StaticJson(nodes, chars, i).toJsonValue());
+    }
+    return JsonValue(std::move(result));
+  }
+  case JsonValueType::none: {
+    return JsonValue::none();
+  }
+  }
+  return JsonValue::none();
+}
+
+} // namespace nuo
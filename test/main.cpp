@@ -1,9 +1,24 @@
+#include "nuo/arena.hpp"
 #include "nuo/exception.hpp"
 #include "nuo/json.hpp"
+#include "nuo/json_binding.hpp"
+#include "nuo/json_diff.hpp"
+#include "nuo/json_document.hpp"
+#include "nuo/json_lines.hpp"
+#include "nuo/json_parser.hpp"
+#include "nuo/json_patch.hpp"
+#include "nuo/json_pointer.hpp"
+#include "nuo/json_reader.hpp"
+#include "nuo/json_ref.hpp"
+#include "nuo/lazy_json.hpp"
 #include "nuo/maybe.hpp"
+#include "nuo/static_json.hpp"
 #include "nuo/vague.hpp"
 #include "nuo/vec.hpp"
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
 #define STRINGIFY(a) str_val(a)
 
@@ -24,6 +39,41 @@
             << "\e[1;34m" << name << "\e[0m"                                   \
             << "\n";
 
+class Address {
+public:
+  std::string city;
+  std::optional<int> zip;
+
+  static constexpr auto jsonFields() {
+    return std::make_tuple(nuo::JsonField("city", &Address::city),
+                           nuo::JsonField("zip", &Address::zip));
+  }
+};
+
+class Account {
+public:
+  int64_t id = 0;
+  std::string name;
+  double score = 0;
+  bool active = false;
+  std::vector<Address> addresses;
+  nuo::JsonValue extra;
+
+  static constexpr auto jsonFields() {
+    return std::make_tuple(nuo::JsonField("id", &Account::id),
+                           nuo::JsonField("name", &Account::name),
+                           nuo::JsonField("score", &Account::score),
+                           nuo::JsonField("active", &Account::active),
+                           nuo::JsonField("addresses", &Account::addresses),
+                           nuo::JsonField("extra", &Account::extra));
+  }
+};
+
+static_assert(R"({"port": 8080, "hosts": ["a", "b"]})"_cjson["port"].asInt() ==
+              8080);
+static_assert(R"({"port": 8080, "hosts": ["a", "b"]})"_cjson["hosts"].at(1)
+                  .asString() == "b");
+
 int main() {
   using nuo::Json;
   using nuo::Maybe;
@@ -82,6 +132,17 @@ int main() {
   ASSERT(vge1.has() == true)
   ASSERT(vge1.getOr(50) == 34)
 
+  GROUP("Arena")
+  auto arena = nuo::Arena(16);
+  auto arenaText = arena.copy("some text longer than a block");
+  auto arenaNumber = arena.make<int64_t>(42);
+  ASSERT(arenaText == "some text longer than a block")
+  ASSERT(*arenaNumber == 42)
+  ASSERT(((uintptr_t)arenaNumber % alignof(int64_t)) == 0)
+  ASSERT(arena.size() == 37)
+  arena.clear();
+  ASSERT(arena.size() == 0)
+
   GROUP("Json")
   auto json = Json();
   json["hello"] = "hi";
@@ -109,6 +170,665 @@ int main() {
     jsn = another;
     ASSERT(jsn.size() == 1)
     ASSERT(jsn["dfd"] == "some")
+    SUBGROUP("Nested Parsing")
+    auto nested = R"({"a": {"b": [1, [2, {"c": null}], true], "d": 2.5}})"_json;
+    auto inner = nested["a"].asJson();
+    ASSERT(inner["d"] == 2.5)
+    ASSERT(inner["b"].asList().size() == 3)
+    ASSERT(inner["b"].asList()[1].asList()[1] == Json()._("c", nuo::JsonValue()))
+    auto parseError = [](std::string text) {
+      try {
+        Json value(text);
+      } catch (nuo::Exception &err) {
+        return std::string(err.what());
+      }
+      return std::string();
+    };
+    ASSERT(parseError(R"({"a": 1,})") == "Trailing commas are not allowed. "
+                                         "Expected a key after the comma")
+    ASSERT(parseError(R"({"a": [1, 2})") == "Invalid } found")
+    ASSERT(parseError(R"({"a": {"b": 1})") == "End for { could not be found")
+    ASSERT(parseError(R"({"a": true "b"})") ==
+           "Invalid token found after boolean")
+    ASSERT(parseError(R"(["a"])") == "List should not begin outside Json scope")
+    auto valid = Json::tryParse(R"({"ok": [1]})");
+    ASSERT(valid.has() && !valid.hasProblem())
+    ASSERT(valid.getOr(Json())["ok"] == nuo::JsonValue({1}))
+    auto parseProblem = nuo::JsonError();
+    auto invalid = Json::tryParse("{\"a\": 1,\n  \"b\" 2}", parseProblem);
+    ASSERT(!invalid.has() && invalid.hasProblem())
+    ASSERT(invalid.getProblem().get().get() ==
+           "Colon expected after the key (line 2, column 7)")
+    ASSERT(parseProblem.kind == nuo::JsonErrorKind::unexpectedToken)
+    ASSERT(parseProblem.offset == 15)
+    ASSERT(parseProblem.line == 2 && parseProblem.column == 7)
+    Json::tryParse("{\"a\": \"open", parseProblem);
+    ASSERT(parseProblem.kind == nuo::JsonErrorKind::unexpectedEnd)
+    SUBGROUP("Limits")
+    auto limits = nuo::JsonLimits();
+    limits.maxDepth = 3;
+    std::string limited = R"({"a": [{"b": "a string that is long enough"}]})";
+    ASSERT(Json::tryParse(limited, limits, parseProblem).has())
+    ASSERT(!Json::tryParse(R"({"a": [[{}]]})", limits, parseProblem).has())
+    ASSERT(parseProblem.kind == nuo::JsonErrorKind::depthLimit)
+    ASSERT(parseProblem.offset == 8)
+    limits.maxBytes = 20;
+    ASSERT(!Json::tryParse(limited, limits, parseProblem).has())
+    ASSERT(parseProblem.kind == nuo::JsonErrorKind::sizeLimit)
+    limits = nuo::JsonLimits();
+    limits.maxStringLength = 16;
+    ASSERT(!Json::tryParse(limited, limits, parseProblem).has())
+    ASSERT(parseProblem.kind == nuo::JsonErrorKind::stringLimit)
+    ASSERT(parseProblem.message == "String is longer than the limit of 16 bytes")
+    limits = nuo::JsonLimits();
+    limits.maxAllocation = 4096;
+    ASSERT(Json::tryParse(limited, limits, parseProblem).has())
+    limits.maxAllocation = 64;
+    ASSERT(!Json::tryParse(limited, limits, parseProblem).has())
+    ASSERT(parseProblem.kind == nuo::JsonErrorKind::allocationLimit)
+    // The text of a repeated key is only counted once, so this is less than
+    // the limit although the key text alone is 100 * 200 bytes
+    std::string repeatedKeys = "{\"list\": [";
+    for (int i = 0; i < 100; i++) {
+      repeatedKeys += (i ? ", {\"" : "{\"") + std::string(200, 'k') + "\": 1}";
+    }
+    repeatedKeys += "]}";
+    limits.maxAllocation = 100 * 200;
+    ASSERT(Json::tryParse(repeatedKeys, limits, parseProblem).has())
+    // The index of an object with many keys is counted, which has 2048 slots
+    // for 1000 keys
+    std::string indexedKeys = "{";
+    for (int i = 0; i < 1000; i++) {
+      indexedKeys += (i ? ", \"idx" : "\"idx") + std::to_string(i) + "\": 1";
+    }
+    indexedKeys += "}";
+    auto withoutIndex =
+        sizeof(nuo::JsonValue) + sizeof(Json) +
+        1000 * (sizeof(nuo::JsonKey) + sizeof(std::string) +
+                sizeof(nuo::JsonValue));
+    limits.maxAllocation = withoutIndex + 2048 * sizeof(uint32_t);
+    ASSERT(Json::tryParse(indexedKeys, limits, parseProblem).has())
+    limits.maxAllocation = withoutIndex + 1000;
+    ASSERT(!Json::tryParse(indexedKeys, limits, parseProblem).has())
+    limits = nuo::JsonLimits();
+    limits.maxStringLength = 4;
+    auto shortReader = nuo::JsonReader(limits);
+    std::string readerError;
+    try {
+      shortReader.feed("[\"abc\", \"");
+      for (int i = 0; i < 10; i++) {
+        shortReader.feed("0123");
+      }
+    } catch (nuo::Exception &err) {
+      readerError = err.what();
+    }
+    ASSERT(readerError == "String is longer than the limit of 4 bytes")
+    SUBGROUP("Numbers")
+    auto numbers = Json(R"({"big": 9223372036854775807, "low": -9223372036854775808,
+      "over": 18446744073709551616, "exp": 1e3, "neg": -2.5E-2, "whole": 4.00,
+      "tiny": 1e-400})");
+    ASSERT(numbers["big"] == (int64_t)INT64_MAX)
+    ASSERT(numbers["low"] == (int64_t)INT64_MIN)
+    ASSERT(numbers["over"] == 18446744073709551616.0)
+    ASSERT(numbers["exp"] == 1000.0)
+    ASSERT(numbers["neg"] == -0.025)
+    ASSERT(numbers["whole"].isInt() && (numbers["whole"] == 4))
+    ASSERT(numbers["tiny"] == 0.0)
+    ASSERT(parseError(R"({"a": 01})") == "Invalid symbol found at 7")
+    ASSERT(parseError(R"({"a": 1.})") == "Invalid number found at 6")
+    ASSERT(parseError(R"({"a": -})") == "Invalid number found at 6")
+    ASSERT(parseError(R"({"a": 1e})") == "Invalid number found at 6")
+    ASSERT(parseError(R"({"a": 1e999})") == "Number is out of range at 6")
+    SUBGROUP("Strings")
+    auto strings = Json(
+        R"({"escapes": "\u00e9\/\r\ud83d\ude00", "raw": "é😀 ü"})");
+    ASSERT(strings["escapes"] == "\u00e9/\r\U0001F600")
+    ASSERT(strings["raw"] == "\u00e9\U0001F600 \u00fc")
+    ASSERT(parseError(R"({"a": "\ud83d"})") ==
+           "Invalid unicode escape found in json string")
+    ASSERT(parseError(R"({"a": "\u12g4"})") ==
+           "Invalid unicode escape found in json string")
+    ASSERT(parseError("{\"a\": \"ok\xC3\x28\"}") ==
+           "Invalid UTF-8 found in json string at 9")
+    ASSERT(parseError("{\"a\": \"\xED\xA0\x80\"}") ==
+           "Invalid UTF-8 found in json string at 7")
+    ASSERT(parseError("{\"a\": \"tab\there\"}") ==
+           "Control character found in json string at 10")
+    ASSERT(parseError("{\"a\nb\": 1}") ==
+           "Control character found in json string at 3")
+    // Decoded control characters and quotes in keys are escaped again
+    auto controls = Json(R"({"k\"\u0001": "\r\u0000\u001f\n"})");
+    ASSERT(controls.toString() ==
+           "{\n  \"k\\\"\\u0001\" : \"\\r\\u0000\\u001f\\n\"\n}")
+    ASSERT(Json(controls.toString()) == controls)
+    // Strings of up to 14 bytes are inline, and longer ones are on the heap
+    auto inlineText = nuo::JsonValue("fourteen bytes");
+    auto heapText = nuo::JsonValue("fifteen bytes..");
+    auto copiedText = heapText;
+    copiedText = inlineText;
+    heapText = std::string("a string that does not fit");
+    ASSERT(sizeof(nuo::JsonValue) == 16)
+    ASSERT(inlineText == "fourteen bytes" && copiedText == inlineText)
+    ASSERT(heapText.asString() == "a string that does not fit")
+    ASSERT(Json(R"({"a": "\u00e9t\u00e9", "b": "\n"})")["a"].asString() ==
+           "\u00e9t\u00e9")
+    SUBGROUP("Event Parsing")
+    class Counter {
+    public:
+      int objects = 0;
+      int lists = 0;
+      int keys = 0;
+      int64_t total = 0;
+      std::string names;
+
+      void startObject() { objects++; }
+      void endObject() {}
+      void startList() { lists++; }
+      void endList() {}
+      void key(std::string_view key) { keys++; }
+      void string(std::string_view val) { names += val; }
+      void integer(int64_t val) { total += val; }
+      void decimal(double val) {}
+      void boolean(bool val) {}
+      void null() {}
+    };
+    auto counter = Counter();
+    nuo::JsonParser::sax(
+        R"({"a": [1, 2, {"b": 3}], "c": "x"} [4, "y\n"] 5)", counter);
+    ASSERT(counter.objects == 2)
+    ASSERT(counter.lists == 2)
+    ASSERT(counter.keys == 3)
+    ASSERT(counter.total == 15)
+    ASSERT(counter.names == "xy\n")
+    SUBGROUP("Incremental Reading")
+    auto reader = nuo::JsonReader();
+    std::string text = R"({"name": "a\"b", "list": [12, -3.5, true]} 42)";
+    auto readValue = nuo::JsonValue();
+    int values = 0;
+    for (std::size_t i = 0; i < text.size(); i += 3) {
+      reader.feed(std::string_view(text).substr(i, 3));
+      while (reader.nextValue(readValue)) {
+        values++;
+        if (values == 1) {
+          ASSERT(readValue.asJson()["name"] == "a\"b")
+          ASSERT(readValue.asJson()["list"] ==
+                 std::vector<nuo::JsonValue>({12, -3.5, true}))
+        }
+      }
+    }
+    reader.feed("7");
+    reader.finish();
+    bool lastValue = reader.nextValue(readValue);
+    ASSERT(lastValue)
+    ASSERT(readValue == 427)
+    ASSERT(values == 1)
+    // Positions in errors are counted from the start of the input
+    auto readerProblem = [](std::vector<std::string> chunks) {
+      auto chunked = nuo::JsonReader();
+      try {
+        for (auto &chunk : chunks) {
+          chunked.feed(chunk);
+        }
+        chunked.finish();
+      } catch (nuo::Exception &err) {
+        return std::string(err.what());
+      }
+      return std::string();
+    };
+    ASSERT(readerProblem({"[1, 2, ", "\"ab\x01\"]"}) ==
+           "Control character found in json string at 10")
+    ASSERT(readerProblem({"[1, 2", "3, tr", "ux]"}) ==
+           "Invalid symbol found `tru` at 8")
+    ASSERT(readerProblem({"[1, ", "}"}) == "Invalid } found at 4")
+    ASSERT(readerProblem({"{\"a\": [1, ", "2"}) ==
+           "End for [ could not be found at 11")
+    SUBGROUP("Documents & Files")
+    std::string docText =
+        R"({"id": 7, "name": "plain", "quote": "a\"b", "list": [1, {"x": 2.5}]})";
+    {
+      std::ofstream out("nuo_test_document.json");
+      out << docText;
+    }
+    auto fileJson = Json::fromFile("nuo_test_document.json");
+    ASSERT(fileJson == Json(docText))
+    auto doc = nuo::JsonDocument::fromFile("nuo_test_document.json");
+    auto docRoot = doc.root();
+    ASSERT(docRoot["id"].asInt() == 7)
+    ASSERT(docRoot["name"].asString() == "plain")
+    ASSERT(docRoot["quote"].asString() == "a\"b")
+    ASSERT(docRoot["list"].size() == 2)
+    ASSERT(docRoot["list"].at(1)["x"].asDouble() == 2.5)
+    ASSERT(docRoot["missing"].isNone())
+    ASSERT(docRoot.toJsonValue() == fileJson)
+    std::string docKeys;
+    docRoot.forEachMember([&](std::string_view key, auto value) {
+      docKeys += std::string(key) + (value.isList() ? "[];" : ";");
+    });
+    ASSERT(docKeys == "id;name;quote;list[];")
+    double docSum = 0;
+    docRoot["list"].forEachElement([&](auto value) {
+      docSum += value.isInt() ? value.asInt() : value["x"].asDouble();
+    });
+    ASSERT(docSum == 3.5)
+    auto duplicateDoc = nuo::JsonDocument(R"({"d": 1, "e": [], "d": 2})");
+    ASSERT(duplicateDoc.root()["d"].asInt() == 2)
+    ASSERT(duplicateDoc.root()["d"].asInt() ==
+           nuo::JsonRef(duplicateDoc.root().toJsonValue())["d"].asInt())
+    std::remove("nuo_test_document.json");
+    SUBGROUP("Token Tape")
+    std::string tapeText = R"([{"a": [1, 2]}, "s", -1.5e3])";
+    auto tape = nuo::JsonParser::lex(tapeText);
+    ASSERT(tape.size() == 15)
+    ASSERT(tape.matches[0] == 14)
+    ASSERT(tape.skip(1) == 10)
+    ASSERT(tape.source(tapeText, 4) == "[1, 2]")
+    ASSERT(tape.source(tapeText, 13) == "-1.5e3")
+    ASSERT(sizeof(tape.types[0]) == 1)
+    SUBGROUP("Json Pointer")
+    std::string pointerText =
+        R"({"skip": {"x": "}]\"", "y": [[{}]]}, "a/b": [10, {"m~n": true}], "user": {"id": 42}})";
+    ASSERT(nuo::JsonPointer("/user/id").get(pointerText) == 42)
+    ASSERT(nuo::JsonPointer("/a~1b/1/m~0n").get(pointerText) == true)
+    ASSERT(nuo::JsonPointer("/a~1b/1/m~0n").toString() == "/a~1b/1/m~0n")
+    ASSERT(nuo::JsonPointer("/skip/y").find(pointerText).get() == "[[{}]]")
+    ASSERT(nuo::JsonPointer("").find(pointerText).get() == pointerText)
+    ASSERT(nuo::JsonPointer("/a~1b/2").get(pointerText).isNone())
+    ASSERT(nuo::JsonPointer("/a~1b/01").get(pointerText).isNone())
+    ASSERT(nuo::JsonPointer("/user/id/deeper").get(pointerText).isNone())
+    ASSERT(!nuo::JsonPointer("/missing").find(pointerText).has())
+    // The last duplicate key is used, like in Json and LazyJson
+    std::string duplicateText =
+        R"({"a": {"b": 1}, "c": 2, "a": {"b": [3, 4]}, "c": 5})";
+    ASSERT(nuo::JsonPointer("/a/b/1").get(duplicateText) == 4)
+    ASSERT(nuo::JsonPointer("/c").get(duplicateText) ==
+           Json(duplicateText)["c"])
+    ASSERT(nuo::JsonPointer("/a").find(duplicateText).get() ==
+           R"({"b": [3, 4]})")
+    ASSERT(nuo::JsonPointer("/a/b").get(duplicateText) ==
+           nuo::LazyJson(duplicateText).object("a")["b"])
+    // The match is lexed again after the index has moved past its window
+    std::string farText = R"({"a": {"b": [1, 2]}, "pad": ")" +
+                          std::string(70000, 'x') + R"(", "c": 3})";
+    ASSERT(nuo::JsonPointer("/a/b/1").get(farText) == 2)
+    ASSERT(nuo::JsonPointer("/c").get(farText) == 3)
+    SUBGROUP("Json Patch")
+    auto patched = Json(R"({"foo": {"bar": "baz", "waldo": "fred"},
+                            "qux": {"corge": "grault"}, "list": [1, 2, 3]})");
+    nuo::JsonPatch(R"([{"op": "move", "from": "/foo/waldo", "path": "/qux/thud"},
+                       {"op": "add", "path": "/list/1", "value": {"x": [true]}},
+                       {"op": "add", "path": "/list/-", "value": 4},
+                       {"op": "remove", "path": "/list/0"},
+                       {"op": "replace", "path": "/foo/bar", "value": null},
+                       {"op": "copy", "from": "/list/0", "path": "/copied"},
+                       {"op": "test", "path": "/list/1", "value": 2.0},
+                       {"op": "test", "path": "/copied", "value": {"x": [true]}}])")
+        .apply(patched);
+    ASSERT(patched == Json(R"({"foo": {"bar": null}, "qux": {"corge": "grault",
+        "thud": "fred"}, "list": [{"x": [true]}, 2, 3, 4], "copied": {"x": [true]}})"))
+    auto unchanged = patched;
+    std::string patchError;
+    try {
+      nuo::JsonPatch(R"([{"op": "move", "from": "/foo", "path": "/list/0"},
+                         {"op": "remove", "path": "/qux/corge"},
+                         {"op": "add", "path": "", "value": {"a": 1}},
+                         {"op": "test", "path": "/a", "value": 2}])")
+          .apply(patched);
+    } catch (nuo::Exception &err) {
+      patchError = err.what();
+    }
+    ASSERT(patchError ==
+           "JSON Patch operation 3 failed: The value at /a is not the tested value")
+    ASSERT(patched == unchanged)
+    try {
+      nuo::JsonPatch(R"([{"op": "move", "from": "/qux", "path": "/qux/inner"}])")
+          .apply(patched);
+    } catch (nuo::Exception &err) {
+      patchError = err.what();
+    }
+    ASSERT(patchError ==
+           "JSON Patch operation 0 failed: A value cannot be moved into itself")
+    try {
+      nuo::JsonPatch(R"([{"op": "move", "from": "/list/0", "path": "/none/x"}])")
+          .apply(patched);
+    } catch (nuo::Exception &err) {
+      patchError = err.what();
+    }
+    ASSERT(patched == unchanged)
+    try {
+      nuo::JsonPatch(R"([{"op": "replace", "path": "/x"}])");
+    } catch (nuo::Exception &err) {
+      patchError = err.what();
+    }
+    ASSERT(patchError == "JSON Patch operation 0 is not valid: \"value\" is "
+                         "required for replace")
+    auto reusable = nuo::JsonPatch(
+        nuo::JsonValue({Json()._("op", "add")._("path", "/n")._("value", 1)}));
+    auto first = Json();
+    auto second = Json()._("n", 0);
+    reusable.apply(first);
+    reusable.apply(second);
+    ASSERT(first == second && first["n"] == 1)
+    bool erasedOnce = second.erase("n");
+    bool erasedTwice = second.erase("n");
+    ASSERT(erasedOnce && !erasedTwice && second.size() == 0)
+    SUBGROUP("Json Diff")
+    auto before = Json(R"({"name": "nuo", "tags": ["a", "b", "c", "d"],
+                           "a/b": {"x": 1, "y": [1, 2]}, "old": true})");
+    auto after = Json(R"({"name": "nuo", "tags": ["a", "x", "b", "c"],
+                          "a/b": {"x": 1.0, "y": [1, 3]}, "new": null})");
+    auto diff = nuo::JsonDiff::patch(before, after);
+    ASSERT(diff.toString() ==
+           R"([{"op":"remove","path":"/old"},{"op":"add","path":"/tags/1",)"
+           R"("value":"x"},{"op":"remove","path":"/tags/4"},{"op":"replace",)"
+           R"("path":"/a~1b/y/1","value":3},{"op":"add","path":"/new",)"
+           R"("value":null}])")
+    auto diffed = before;
+    nuo::JsonPatch(diff.toString()).apply(diffed);
+    ASSERT(nuo::JsonDiff::patch(diffed, after).operations().empty())
+    ASSERT(nuo::JsonDiff::patch(after, after).operations().empty())
+    auto reordered = Json(R"({"b": [1, {"c": 2}], "a": 1})");
+    auto ordered = Json(R"({"a": 1.0, "b": [1, {"c": 2}]})");
+    ASSERT(nuo::JsonDiff::patch(reordered, ordered).operations().empty())
+    auto merge = nuo::JsonDiff::mergePatch(before, after);
+    ASSERT(merge == Json(R"({"old": null, "tags": ["a", "x", "b", "c"],
+                             "a/b": {"y": [1, 3]}})"))
+    nuo::JsonDiff::applyMergePatch(before, merge);
+    ASSERT(before == Json(R"({"name": "nuo", "tags": ["a", "x", "b", "c"],
+                              "a/b": {"x": 1, "y": [1, 3]}})"))
+    ASSERT(nuo::JsonDiff::mergePatch(before, before).size() == 0)
+    // Integers above 2^53 are compared exactly, even in lists
+    auto bigBefore = Json(R"({"id": 9007199254740992, "ids": [9007199254740992, 1]})");
+    auto bigAfter = Json(R"({"id": 9007199254740993, "ids": [9007199254740993, 1]})");
+    ASSERT(nuo::JsonDiff::patch(bigBefore, bigAfter).toString() ==
+           R"([{"op":"replace","path":"/id","value":9007199254740993},)"
+           R"({"op":"replace","path":"/ids/0","value":9007199254740993}])")
+    ASSERT(nuo::JsonDiff::mergePatch(bigBefore, bigAfter).size() == 2)
+    SUBGROUP("Key Interning")
+    auto globalKey = nuo::JsonKey("interned key");
+    auto globalKeys = nuo::JsonKeyTable::global().size();
+    auto records = Json(R"({"interned key": [{"interned key": 1}]})");
+    ASSERT(nuo::JsonKeyTable::global().size() == globalKeys)
+    ASSERT(globalKey == nuo::JsonKey("interned key") && globalKey != "other")
+    auto scopedJson = Json();
+    {
+      nuo::JsonKeyTable documentKeys;
+      auto scope = nuo::JsonKeyTable::Scope(documentKeys);
+      scopedJson = Json(R"({"interned key": 3, "only here": true})");
+      ASSERT(documentKeys.size() == 2)
+      ASSERT(nuo::JsonKey("interned key") == globalKey)
+    }
+    // Keys outlive their table, and are compared as text with other tables
+    ASSERT(nuo::JsonKeyTable::global().size() == globalKeys)
+    ASSERT(scopedJson.has("only here") && scopedJson["interned key"] == 3)
+    scopedJson._("interned key", 4);
+    ASSERT(scopedJson.size() == 2 && scopedJson["interned key"] == 4)
+    // Entries are removed when the last key for them is dropped
+    {
+      auto uniqueKeys = Json(R"({"dropped 1": 1, "dropped 2": {"dropped 3": 3}})");
+      ASSERT(nuo::JsonKeyTable::global().size() == globalKeys + 3)
+    }
+    ASSERT(nuo::JsonKeyTable::global().size() == globalKeys)
+    ASSERT(!nuo::Json::tryParse(R"({"dropped 4": 1, "dropped 5": })").has())
+    ASSERT(nuo::JsonKeyTable::global().size() == globalKeys)
+    SUBGROUP("Shared Values")
+    auto shared = Json(R"({"inner": {"list": [1, {"deep": true}]},
+                          "text": "a string that is not inline"})");
+    auto sharedText = shared.toString();
+    auto sharedCopy = shared;
+    auto sharedValue = shared["inner"];
+    ASSERT(sharedCopy == shared && sharedValue == shared["inner"])
+    nuo::JsonPatch(R"([{"op": "replace", "path": "/inner/list/1/deep", "value": false},
+                       {"op": "add", "path": "/inner/list/-", "value": 3}])")
+        .apply(sharedCopy);
+    ASSERT(sharedCopy["inner"] != shared["inner"])
+    ASSERT(shared.toString() == sharedText && sharedValue == shared["inner"])
+    nuo::JsonDiff::applyMergePatch(sharedCopy, Json()._("inner", Json()._("list", 0)));
+    ASSERT(sharedCopy["inner"] == Json()._("list", 0))
+    ASSERT(shared.toString() == sharedText)
+    sharedCopy["text"] = "another string that is not inline";
+    ASSERT(shared["text"] == "a string that is not inline")
+    sharedCopy.setSpaces(4);
+    ASSERT(shared.toString() == sharedText)
+    // Values that are only read by a patch stay shared
+    auto sharedRead = shared;
+    nuo::JsonPatch(R"([{"op": "test", "path": "/inner/list/1/deep", "value": true},
+                       {"op": "copy", "from": "/inner/list", "path": "/again"}])")
+        .apply(sharedRead);
+    ASSERT(&sharedRead["inner"].viewJson() == &shared["inner"].viewJson())
+    ASSERT(sharedRead["again"].viewList().data() ==
+           nuo::JsonRef(shared)["inner"]["list"].asList().data())
+    SUBGROUP("Borrowed Values")
+    auto borrowed = Json(R"({"users": [{"name": "a name that is long", "id": 1},
+                                       {"name": "b", "tags": ["x", null]}],
+                            "count": 2, "ratio": 0.5, "on": true})");
+    auto users = borrowed["users"];
+    ASSERT(users.viewList().size() == 2 && users.viewList()[1].isJson())
+    ASSERT(users.viewList()[0].viewJson().size() == 2)
+    ASSERT(users.viewList()[1].viewJson().has("tags"))
+    auto root = nuo::JsonRef(borrowed);
+    ASSERT(root.isJson() && root.size() == 4 && root.has("count"))
+    ASSERT(root["users"].at(0)["name"].asString() == "a name that is long")
+    ASSERT(root["users"].at(1)["name"].asString() == "b")
+    ASSERT(root["count"].asInt() == 2 && root["ratio"].asDouble() == 0.5)
+    ASSERT(root["on"].isBool() && root["on"].asBool())
+    ASSERT(root["users"].isList() && root["users"].asList().size() == 2)
+    ASSERT(&root["users"].at(1).asJson() == &users.viewList()[1].viewJson())
+    ASSERT(root.at(nuo::JsonPointer("/users/1/tags/1")).isNull())
+    ASSERT(root.at(nuo::JsonPointer("/users/1/tags/0")).asString() == "x")
+    ASSERT(root.at(nuo::JsonPointer("/users/-")).isNone())
+    ASSERT(root.at(nuo::JsonPointer("/count/x")).isNone())
+    ASSERT(root["missing"]["deeper"].at(3).isNone() && !root.has("missing"))
+    ASSERT(root["users"].at(2).isNone() && root["count"].size() == 0)
+    ASSERT(root.at(nuo::JsonPointer("/users/1")).toJsonValue() ==
+           Json()._("name", "b")._("tags", {"x", nuo::JsonValue()}))
+    ASSERT(root.toJsonValue() == borrowed)
+    ASSERT(nuo::JsonRef(users).at(0)["id"].asInt() == 1)
+    std::string memberKeys;
+    root.forEachMember([&](std::string_view key, nuo::JsonRef member) {
+      memberKeys += std::string(key) + (member.isList() ? "[] " : " ");
+    });
+    ASSERT(memberKeys == "users[] count ratio on ")
+    SUBGROUP("Large Objects")
+    auto large = Json();
+    std::string largeText = "{";
+    for (int i = 0; i < 1000; i++) {
+      large._("key" + std::to_string(i), i);
+      largeText += (i ? ", \"key" : "\"key") + std::to_string(i) + "\": " +
+                   std::to_string(i);
+    }
+    largeText += ", \"key5\": 50}";
+    auto parsedLarge = Json(largeText);
+    ASSERT(parsedLarge.size() == 1000 && parsedLarge["key5"] == 50)
+    ASSERT(parsedLarge["key999"] == 999 && !parsedLarge.has("key1000"))
+    ASSERT(large.size() == 1000 && large["key0"] == 0 && large["key999"] == 999)
+    ASSERT(large.toString().find("{\n  \"key0\" : 0,\n  \"key1\" : 1,") == 0)
+    auto largeErased = large.erase("key500");
+    ASSERT(largeErased && !large.has("key500") && large["key501"] == 501)
+    large["key500"] = 5000;
+    ASSERT(large["key500"] == 5000 && large.size() == 1000)
+    ASSERT(large.toString().rfind("\"key500\" : 5000\n}") != std::string::npos)
+    auto largePatched = large;
+    nuo::JsonPatch(R"([{"op": "remove", "path": "/key10"},
+                       {"op": "add", "path": "/added", "value": 1},
+                       {"op": "move", "from": "/key20", "path": "/moved"}])")
+        .apply(largePatched);
+    ASSERT(!largePatched.has("key10") && !largePatched.has("key20"))
+    ASSERT(largePatched["moved"] == 20 && largePatched["key999"] == 999)
+    ASSERT(large.has("key10") && !large.has("moved"))
+    try {
+      nuo::JsonPatch(R"([{"op": "remove", "path": "/key30"},
+                         {"op": "add", "path": "/other", "value": 2},
+                         {"op": "test", "path": "/key31", "value": 0}])")
+          .apply(largePatched);
+    } catch (nuo::Exception &err) {
+    }
+    ASSERT(largePatched["key30"] == 30 && !largePatched.has("other"))
+    ASSERT(largePatched.size() == 1000 && largePatched["key31"] == 31)
+    nuo::JsonDiff::applyMergePatch(largePatched, Json()._("key40", nuo::JsonValue()));
+    ASSERT(!largePatched.has("key40") && largePatched["key41"] == 41)
+    ASSERT(nuo::JsonRef(large)["key700"].asInt() == 700)
+    auto crossTable = Json();
+    {
+      nuo::JsonKeyTable largeKeys;
+      auto scope = nuo::JsonKeyTable::Scope(largeKeys);
+      crossTable = Json(largeText);
+    }
+    ASSERT(crossTable["key123"] == 123 && crossTable == parsedLarge)
+    crossTable._("key123", 0);
+    ASSERT(crossTable["key123"] == 0 && crossTable.size() == 1000)
+    SUBGROUP("Typed Binding")
+    auto account = nuo::JsonBinding<Account>::parse(
+        R"({"id": 7, "unknown": {"x": [1, 2]}, "name": "n\"a", "score": 2,
+            "addresses": [{"city": "c", "zip": null}, {"city": "d", "zip": 5}],
+            "active": true, "extra": [1, {"k": "v"}]})");
+    ASSERT(account.id == 7)
+    ASSERT(account.name == "n\"a")
+    ASSERT(account.score == 2.0)
+    ASSERT(account.active)
+    ASSERT(account.addresses.size() == 2)
+    ASSERT(!account.addresses[0].zip.has_value())
+    ASSERT(account.addresses[1].zip.value() == 5)
+    ASSERT(account.extra == nuo::JsonValue({1, Json()._("k", "v")}))
+    ASSERT(nuo::JsonBinding<Account>::find("addresses") == 4)
+    ASSERT(nuo::JsonBinding<Account>::find("other") == -1)
+    auto serialized = nuo::JsonBinding<Account>::serialize(account);
+    ASSERT(serialized ==
+           R"({"id":7,"name":"n\"a","score":2,"active":true,"addresses":[{"city":"c","zip":null},{"city":"d","zip":5}],"extra":[1,{"k":"v"}]})")
+    auto roundTrip = nuo::JsonBinding<Account>::parse(serialized);
+    ASSERT(nuo::JsonBinding<Account>::serialize(roundTrip) == serialized)
+    ASSERT(nuo::JsonBinding<Account>::parse(R"({"n\u0061me": "x"})").name == "x")
+    std::string bindError;
+    try {
+      nuo::JsonBinding<Account>::parse(R"({"id": "seven"})");
+    } catch (nuo::Exception &err) {
+      bindError = err.what();
+    }
+    ASSERT(bindError == "Expected an integer at 7")
+    // Members that are not bound are still checked like the tree parser does
+    auto bindProblem = [](const char *text) {
+      try {
+        nuo::JsonBinding<Account>::parse(text);
+      } catch (nuo::Exception &err) {
+        return std::string(err.what());
+      }
+      return std::string();
+    };
+    ASSERT(bindProblem(R"({"x": [1,,}, "id": 1})") == "Expected a value at 9")
+    ASSERT(bindProblem(R"({"x": {"a" 1}})") == "Expected a colon after the key at 11")
+    ASSERT(bindProblem(R"({"x": [1, 2}})") == "Expected , or ] at 11")
+    ASSERT(bindProblem(R"({"x": {"a": 1,}})") == "Expected a key at 14")
+    ASSERT(bindProblem(R"({"x": [1 2]})") == "Expected , or ] at 9")
+    ASSERT(bindProblem(R"({"x": [{}, [[]], {"a": [null]}], "id": 3})").empty())
+    SUBGROUP("Static Literals")
+    constexpr auto config =
+        R"({"name": "n\u00e9\ud83d\ude00", "rate": 0.1, "big": 1e300,
+            "small": -2.5e-3, "whole": 3.00, "min": -9223372036854775808,
+            "flags": [true, false, null], "empty": {}})"_cjson;
+    ASSERT(config.size() == 8)
+    ASSERT(config["name"].asString() == "n\u00e9\U0001F600")
+    ASSERT(config["rate"].asDouble() == 0.1)
+    ASSERT(config["big"].asDouble() == 1e300)
+    ASSERT(config["small"].asDouble() == -2.5e-3)
+    ASSERT(config["whole"].isInt() && config["whole"].asInt() == 3)
+    ASSERT(config["min"].asInt() == INT64_MIN)
+    ASSERT(config["flags"].at(1).isBool() && !config["flags"].at(1).asBool())
+    ASSERT(config["flags"].at(2).isNull())
+    ASSERT(config["flags"].at(3).isNone())
+    ASSERT(config["missing"].isNone())
+    ASSERT(config["empty"].isJson() && config["empty"].size() == 0)
+    ASSERT(config.toJsonValue() ==
+           nuo::JsonValue(Json(R"({"name": "n\u00e9\ud83d\ude00", "rate": 0.1,
+               "big": 1e300, "small": -2.5e-3, "whole": 3.00,
+               "min": -9223372036854775808, "flags": [true, false, null],
+               "empty": {}})")))
+    ASSERT(R"(["x"])"_cjson.at(0).asString().data() ==
+           R"(["x"])"_cjson.at(0).asString().data())
+    constexpr auto duplicateLiteral = R"({"k": 1, "j": {}, "k": [2]})"_cjson;
+    static_assert(duplicateLiteral["k"].at(0).asInt() == 2);
+    ASSERT(duplicateLiteral["k"].toJsonValue() ==
+           Json(R"({"k": 1, "j": {}, "k": [2]})")["k"])
+    SUBGROUP("Lazy Parsing")
+    auto lazy = nuo::LazyJson(
+        R"({"skip": [1, {"deep": [2]}], "id": 9, "k\"ey": "v", "user": {"name": "n", "age": 3}})");
+    ASSERT(lazy.size() == 4)
+    ASSERT(lazy["id"] == 9)
+    ASSERT(lazy["k\"ey"] == "v")
+    ASSERT(lazy["missing"].isNone())
+    ASSERT(lazy.object("user")["age"] == 3)
+    ASSERT(lazy.toJson() == Json(R"({"skip": [1, {"deep": [2]}], "id": 9, "k\"ey": "v", "user": {"name": "n", "age": 3}})"))
+    SUBGROUP("JSON Lines")
+    std::string lines;
+    for (int i = 0; i < 200; i++) {
+      lines += "{\"id\": " + std::to_string(i) + "}\n" + (i % 7 ? "" : "\n");
+    }
+    std::vector<int> ids;
+    auto orderedInput = std::istringstream(lines);
+    nuo::JsonLines(3, 64).read(orderedInput, [&](Json &&record, size_t) {
+      ids.push_back((int)record["id"].asInt());
+    });
+    bool inOrder = (ids.size() == 200);
+    for (size_t i = 0; inOrder && (i < ids.size()); i++) {
+      inOrder = (ids[i] == (int)i);
+    }
+    ASSERT(inOrder)
+    int sum = 0;
+    auto anyInput = std::istringstream(lines);
+    nuo::JsonLines(4, 100, false).read(anyInput, [&](Json &&record, size_t) {
+      sum += (int)record["id"].asInt();
+    });
+    ASSERT(sum == 19900)
+    std::string badLine;
+    auto badInput = std::istringstream("{\"a\": 1}\n{\"a\": }\n{\"a\": 3}\n");
+    try {
+      nuo::JsonLines(2, 1).read(badInput, [](Json &&, size_t) {});
+    } catch (nuo::Exception &err) {
+      badLine = err.what();
+    }
+    ASSERT(badLine.find("line 2") != std::string::npos)
+    limits = nuo::JsonLimits();
+    limits.maxBytes = 1000;
+    auto longInput = std::istringstream("{\"a\": 1}\n{\"a\": \"" +
+                                        std::string(100000, 'x') + "\"}\n");
+    int longRecords = 0;
+    try {
+      nuo::JsonLines(2, 256, true, limits)
+          .read(longInput, [&](Json &&, size_t) { longRecords++; });
+    } catch (nuo::Exception &err) {
+      badLine = err.what();
+    }
+    ASSERT(badLine == "Invalid Json at line 2: Json text is larger than the "
+                      "limit of 1000 bytes")
+    // A line that is much longer than a batch is read in many parts
+    auto wideInput = std::istringstream("{\"a\": \"" +
+                                        std::string(100000, 'y') +
+                                        "\"}\n{\"a\": 2}\n");
+    std::vector<size_t> wideLines;
+    nuo::JsonLines(2, 64).read(wideInput, [&](Json &&record, size_t line) {
+      wideLines.push_back(record["a"].isString() ? line : line * 10);
+    });
+    ASSERT(wideLines == std::vector<size_t>({1, 20}))
+    SUBGROUP("Parallel Lists")
+    auto smallList = nuo::JsonParser::parseList("[1, \"a\", [2]]", 4);
+    ASSERT(nuo::JsonValue(smallList) == nuo::JsonValue({1, "a", {2}}))
+    ASSERT(nuo::JsonParser::parseList(" [ ] ").empty())
+    std::string bigList = "[";
+    for (int i = 0; i < 40000; i++) {
+      bigList += (i ? ", " : "") + std::string("{\"id\": ") +
+                 std::to_string(i) + ", \"tags\": [\"a,]\", {\"b\": null}]}";
+    }
+    bigList += "]";
+    auto parallel = nuo::JsonParser::parseList(bigList, 4);
+    ASSERT(parallel.size() == 40000)
+    ASSERT(parallel == nuo::JsonParser::parseList(bigList, 1))
+    ASSERT(parallel[39999].asJson()["id"] == 39999)
+    std::string listError;
+    bigList.replace(bigList.find("\"id\": 20000,"), 12, "\"id\": 20000],");
+    try {
+      nuo::JsonParser::parseList(bigList, 4);
+    } catch (nuo::Exception &err) {
+      listError = err.what();
+    }
+    ASSERT(listError == "Invalid ] found")
   } catch (nuo::Exception &ex) {
     std::cout << ex.what() << "\n";
   }